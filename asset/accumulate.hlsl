@@ -1,21 +1,106 @@
 #define THREAD_GROUP_WIDTH  16
 #define THREAD_GROUP_HEIGHT 16
 
-cbuffer PerFrame
-{
-    float HistoryWeight;
-    float NewFrameWeight;
-};
+// keeps the relative error of almost black pixels bounded
+#define ERROR_LUMINANCE_BIAS 0.01
+
+// error of pixels with less than two frames
+#define UNKNOWN_ERROR 1e30
+
+// kahan compensations are below the rounding error of their sums, i.e.
+// 2^-24 of them. they are stored relative to their sums and scaled by 2^24,
+// so that a half keeps 11 bits of each
+#define COMPENSATION_SCALE 16777216.0
 
-Texture2D<float4> History;
 Texture2D<float4> NewFrame;
 
-RWTexture2D<float4> Output;
+// written by asset/converge.hlsl
+Texture2D<uint> Converged;
+
+// rgb: kahan-compensated sum of all frames
+// w:   compensations of r and g, packed by packCompensation. alpha of all
+//      frames is 1, so the mean alpha is known from the frame count
+// both textures are updated in place and cleared with the history.
+RWTexture2D<float4> Sum;
+
+// x: frame count
+// y: kahan-compensated m2 of luminance
+// z: relative standard error of mean luminance
+// w: compensations of b and m2, packed by packCompensation
+RWTexture2D<float4> Moments;
+
+float luminance(float3 c)
+{
+    return dot(c, float3(0.2126, 0.7152, 0.0722));
+}
+
+// the halves are moved through the float channels as raw bits, which loads
+// and stores preserve
+
+float packCompensation(float2 comp, float2 sum)
+{
+    float2 relative = sum != 0 ? comp / sum * COMPENSATION_SCALE : 0;
+    return asfloat(f32tof16(relative.x) | (f32tof16(relative.y) << 16));
+}
+
+float2 unpackCompensation(float packed, float2 sum)
+{
+    uint bits = asuint(packed);
+    float2 relative = float2(f16tof32(bits), f16tof32(bits >> 16));
+    return relative * sum / COMPENSATION_SCALE;
+}
 
 [numthreads(THREAD_GROUP_WIDTH, THREAD_GROUP_HEIGHT, 1)]
 void main(int3 threadIdx : SV_DispatchThreadID)
 {
-    float4 history  = History[threadIdx.xy];
-    float4 newFrame = NewFrame[threadIdx.xy];
-    Output[threadIdx.xy] = HistoryWeight * history + NewFrameWeight * newFrame;
+    if(Converged[threadIdx.xy] != 0)
+        return;
+
+    float4 oldSum  = Sum[threadIdx.xy];
+    float4 moments = Moments[threadIdx.xy];
+    float  count   = moments.x + 1;
+
+    // kahan summation. precise keeps the compiler from folding the
+    // compensation away
+
+    float2 compRG = unpackCompensation(oldSum.w, oldSum.rg);
+    float2 compBM = unpackCompensation(moments.w, float2(oldSum.b, moments.y));
+
+    precise float3 sum  = oldSum.rgb;
+    precise float3 comp = float3(compRG, compBM.x);
+
+    float3 oldMean = count > 1 ? (sum - comp) / (count - 1) : 0;
+
+    float3 newFrame = NewFrame[threadIdx.xy].rgb;
+    precise float3 y = newFrame - comp;
+    precise float3 t = sum + y;
+    comp = (t - sum) - y;
+    sum  = t;
+
+    float3 mean = (sum - comp) / count;
+
+    // welford's update of m2, compensated like the sum
+
+    float oldLum = count > 1 ? luminance(oldMean) : 0;
+    float newLum = luminance(newFrame);
+
+    precise float m2     = moments.y;
+    precise float m2Comp = compBM.y;
+    precise float m2Y    = (newLum - oldLum) * (newLum - luminance(mean)) -
+                           m2Comp;
+    precise float m2T    = m2 + m2Y;
+    m2Comp = (m2T - m2) - m2Y;
+    m2     = m2T;
+
+    float error = UNKNOWN_ERROR;
+    if(count > 1)
+    {
+        float stdError = sqrt(max((m2 - m2Comp) / (count - 1), 0) / count);
+        error = stdError / (max(luminance(mean), 0) + ERROR_LUMINANCE_BIAS);
+    }
+
+    Sum[threadIdx.xy] = float4(sum, packCompensation(comp.rg, sum.rg));
+    Moments[threadIdx.xy] = float4(
+        count, m2, error,
+        packCompensation(float2(comp.b, m2Comp), float2(sum.b, m2)));
 }
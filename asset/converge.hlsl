@@ -0,0 +1,69 @@
+#define THREAD_GROUP_WIDTH  16
+#define THREAD_GROUP_HEIGHT 16
+
+// pixels converge when all errors in their neighborhood are small enough
+#define NEIGHBOR_RADIUS 2
+
+cbuffer PerFrame
+{
+    float ErrorThreshold; // <= 0 disables adaptive sampling
+    float MinFrameCount;
+    float MaxFrameCount;
+};
+
+// see asset/accumulate.hlsl
+Texture2D<float4> Moments;
+
+RWTexture2D<uint> Converged;
+
+// 0: number of unconverged pixels
+// 4: estimated number of frames until all pixels converge, summed over
+//    unconverged pixels
+RWByteAddressBuffer Statistics;
+
+[numthreads(THREAD_GROUP_WIDTH, THREAD_GROUP_HEIGHT, 1)]
+void main(int3 threadIdx : SV_DispatchThreadID)
+{
+    uint width, height;
+    Moments.GetDimensions(width, height);
+    if(threadIdx.x >= int(width) || threadIdx.y >= int(height))
+        return;
+
+    if(Converged[threadIdx.xy] != 0)
+        return;
+
+    float4 moments = Moments[threadIdx.xy];
+    float  count   = moments.x;
+
+    float maxError = 0;
+    for(int dy = -NEIGHBOR_RADIUS; dy <= NEIGHBOR_RADIUS; ++dy)
+    {
+        for(int dx = -NEIGHBOR_RADIUS; dx <= NEIGHBOR_RADIUS; ++dx)
+        {
+            int2 p = threadIdx.xy + int2(dx, dy);
+            if(all(p >= 0) && p.x < int(width) && p.y < int(height))
+                maxError = max(maxError, Moments[p].z);
+        }
+    }
+
+    if(ErrorThreshold > 0 && count >= MinFrameCount &&
+       maxError <= ErrorThreshold)
+    {
+        Converged[threadIdx.xy] = 1;
+        return;
+    }
+
+    // errors are assumed to decrease as 1 / sqrt(frame count)
+
+    float needed = MaxFrameCount;
+    if(ErrorThreshold > 0 && count >= 2)
+    {
+        float ratio = moments.z / ErrorThreshold;
+        needed = min(needed, count * ratio * ratio);
+    }
+    needed = max(needed, MinFrameCount);
+
+    uint original;
+    Statistics.InterlockedAdd(0, 1, original);
+    Statistics.InterlockedAdd(4, uint(max(needed - count, 0)), original);
+}
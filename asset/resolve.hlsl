@@ -0,0 +1,32 @@
+#define THREAD_GROUP_WIDTH  16
+#define THREAD_GROUP_HEIGHT 16
+
+// see asset/accumulate.hlsl
+#define COMPENSATION_SCALE 16777216.0
+
+Texture2D<float4> Sum;
+Texture2D<float4> Moments;
+
+RWTexture2D<float4> Output;
+
+float2 unpackCompensation(float packed, float2 sum)
+{
+    uint bits = asuint(packed);
+    float2 relative = float2(f16tof32(bits), f16tof32(bits >> 16));
+    return relative * sum / COMPENSATION_SCALE;
+}
+
+[numthreads(THREAD_GROUP_WIDTH, THREAD_GROUP_HEIGHT, 1)]
+void main(int3 threadIdx : SV_DispatchThreadID)
+{
+    float4 sum     = Sum[threadIdx.xy];
+    float4 moments = Moments[threadIdx.xy];
+    float  count   = moments.x;
+
+    float3 comp = float3(
+        unpackCompensation(sum.w, sum.rg),
+        unpackCompensation(moments.w, float2(sum.b, moments.y)).x);
+
+    Output[threadIdx.xy] = count > 0 ?
+        float4((sum.rgb - comp) / count, 1) : 0;
+}
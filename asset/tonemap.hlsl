@@ -13,7 +13,9 @@ cbuffer PerFrame
 };
 
 Texture2D<float4> HDRImage;
-RWTexture2D<float4> Output;
+
+// R8G8B8A8_UNORM. only displayed, so 8 bits per channel are enough
+RWTexture2D<unorm float4> Output;
 
 [numthreads(THREAD_GROUP_WIDTH, THREAD_GROUP_HEIGHT, 1)]
 void main(int3 threadIdx : SV_DispatchThreadID)
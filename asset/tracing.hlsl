@@ -1,4 +1,5 @@
 // #define MAX_DEPTH 20
+// #define RR_MIN_DEPTH 3
 
 #include "diffuse.hlsl"
 #include "jensen.hlsl"
@@ -22,6 +23,9 @@ cbuffer PerFrame
 
     float3 EnvLight;
     float EyeZ;
+
+    uint PreviewScale;    // each thread traces a block of PreviewScale^2 pixels
+    uint MaxScatterDepth; // paths are absorbed after this many scatterings
 };
 
 struct PaperMaterial
@@ -58,6 +62,9 @@ Texture2D<float4> BackLight;
 
 RWTexture2D<float4> Output;
 
+// non-zero for pixels which need no more samples. see asset/converge.hlsl
+Texture2D<uint> Converged;
+
 float findIntersectionT(float3 rayOri, float3 rayDir, float planeZ)
 {
     if(planeZ < -0.5 || planeZ >= PaperCount + 0.5)
@@ -82,10 +89,10 @@ void generateCameraRay(int2 xy, out float3 ori, out float3 dir)
     }
 }
 
-float4 trace(int3 threadIndex, inout uint rngState)
+float4 trace(int2 pixel, inout uint rngState)
 {
     float3 rayOri, rayDir;
-    generateCameraRay(threadIndex.xy, rayOri, rayDir);
+    generateCameraRay(pixel, rayOri, rayDir);
     float  nextPlaneZ = 0;
 
     float3 coef = float3(1, 1, 1);
@@ -111,8 +118,8 @@ float4 trace(int3 threadIndex, inout uint rngState)
             }
             else
             {
-                bool ox = threadIndex.x / 8 % 2 == 0;
-                bool oy = threadIndex.y / 8 % 2 == 0;
+                bool ox = pixel.x / 8 % 2 == 0;
+                bool oy = pixel.y / 8 % 2 == 0;
                 float v = ox ^ oy ? 0.4 : 0.1;
                 return float4(v, v, v, 0);
             }
@@ -145,7 +152,8 @@ float4 trace(int3 threadIndex, inout uint rngState)
             continue;
         }
 
-        ++scatterDepth;
+        if(++scatterDepth > int(MaxScatterDepth))
+            return float4(0, 0, 0, 1);
 
         // sample bsdf
 
@@ -200,6 +208,17 @@ float4 trace(int3 threadIndex, inout uint rngState)
         float3 color = paperPoint.rgb * float3(1 / 255.0, 1 / 255.0, 1 / 255.0);
 
         coef *= color * throughput;
+
+        // russian roulette
+
+        if(scatterDepth > RR_MIN_DEPTH)
+        {
+            float survival = min(1, max(coef.r, max(coef.g, coef.b)));
+            if(!(randomFloat(rngState) < survival))
+                return float4(0, 0, 0, 1);
+            coef /= survival;
+        }
+
         rayDir = dir;
         rayOri = inct + float3(0, 0, dir.z > 0 ? EPS : -EPS);
         nextPlaneZ += rayDir.z > 0 ? 1 : -1;
@@ -211,16 +230,34 @@ float4 trace(int3 threadIndex, inout uint rngState)
 [numthreads(THREAD_GROUP_WIDTH, THREAD_GROUP_HEIGHT, 1)]
 void main(int3 threadIndex : SV_DispatchThreadID)
 {
-    uint rngState = loadRNG(threadIndex.xy);
+    int2 blockBeg = threadIndex.xy * int(PreviewScale);
+    int2 blockEnd = min(
+        blockBeg + int(PreviewScale), int2(OutputWidth, OutputHeight));
+    if(any(blockBeg >= blockEnd))
+        return;
+
+    // the center pixel of the block is traced
+
+    int2 pixel = min(blockBeg + int(PreviewScale) / 2, blockEnd - 1);
+    if(Converged[pixel] != 0)
+        return;
+
+    uint rngState = loadRNG(pixel);
     
     float4 sum = float4(0, 0, 0, 0);
     for(uint i = 0; i < SPP; ++i)
     {
-        float4 single = trace(threadIndex, rngState);
+        float4 single = trace(pixel, rngState);
         if(!any(isinf(single) | isnan(single)))
             sum += single;
     }
         
-    storeRNG(threadIndex.xy, rngState);
-    Output[threadIndex.xy] = float4(sum.rgb / SPP, 1);
+    storeRNG(pixel, rngState);
+
+    float4 result = float4(sum.rgb / SPP, 1);
+    for(int y = blockBeg.y; y < blockEnd.y; ++y)
+    {
+        for(int x = blockBeg.x; x < blockEnd.x; ++x)
+            Output[int2(x, y)] = result;
+    }
 }
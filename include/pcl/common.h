@@ -1,10 +1,8 @@
 #pragma once
 
 #include <agz-utils/graphics_api.h>
-#include <agz-utils/texture.h>
 
-#define PCL_BEGIN namespace pcl {
-#define PCL_END   }
+#include <pcl/core/common.h>
 
 PCL_BEGIN
 
@@ -12,24 +10,6 @@ namespace d3d11 = agz::d3d11;
 
 using d3d11::ComPtr;
 
-using d3d11::Int2;
-using d3d11::Int3;
-
-using d3d11::Float2;
-using d3d11::Float3;
-using d3d11::Float4;
-using d3d11::Color4;
-
-template<typename T>
-using Image2D = agz::texture::texture2d_t<T>;
-
-class PCLException : public std::runtime_error
-{
-public:
-
-    using runtime_error::runtime_error;
-};
-
 #define PCL_THROW_IF_FAILED_NOMSG(HR)                                           \
     do                                                                          \
     {                                                                           \
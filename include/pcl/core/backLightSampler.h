@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief samples texels of the back light proportional to their luminance
+ *
+ * built from linear radiance (see computeBackLightRadiance) with an alias
+ * table, so that sampling costs O(1) regardless of how sparse the light is.
+ * all texels cover the same area, so luminance is proportional to the power
+ * emitted by the texel.
+ */
+class BackLightSampler
+{
+public:
+
+    BackLightSampler() noexcept;
+
+    /**
+     * @brief rebuild the table from width * height texels in row-major order
+     */
+    void build(int width, int height, const Float3 *radiance);
+
+    /**
+     * @brief false when no texel emits any light
+     */
+    bool isAvailable() const noexcept;
+
+    /**
+     * @brief sample a texel with a uniform random number u in [0, 1)
+     *
+     * @param texelPdf probability of the sampled texel
+     */
+    void sample(float u, int *x, int *y, float *texelPdf) const noexcept;
+
+    /**
+     * @brief probability of sampling texel (x, y)
+     */
+    float getTexelPdf(int x, int y) const noexcept;
+
+private:
+
+    static float getLuminance(const Float3 &radiance) noexcept;
+
+    int width_;
+    int height_;
+
+    std::vector<float>    texelPdf_;
+    std::vector<float>    aliasProb_;
+    std::vector<uint32_t> alias_;
+};
+
+inline bool BackLightSampler::isAvailable() const noexcept
+{
+    return !texelPdf_.empty();
+}
+
+inline void BackLightSampler::sample(
+    float u, int *x, int *y, float *texelPdf) const noexcept
+{
+    assert(isAvailable());
+
+    const uint32_t count = static_cast<uint32_t>(texelPdf_.size());
+    const float    fu    = u * count;
+    const uint32_t slot  = (std::min)(static_cast<uint32_t>(fu), count - 1);
+
+    const uint32_t index = fu - slot < aliasProb_[slot] ? slot : alias_[slot];
+
+    *x        = static_cast<int>(index % width_);
+    *y        = static_cast<int>(index / width_);
+    *texelPdf = texelPdf_[index];
+}
+
+inline float BackLightSampler::getTexelPdf(int x, int y) const noexcept
+{
+    if(!isAvailable())
+        return 0;
+    return texelPdf_[size_t(y) * width_ + x];
+}
+
+inline float BackLightSampler::getLuminance(const Float3 &radiance) noexcept
+{
+    return 0.2126f * radiance.x + 0.7152f * radiance.y + 0.0722f * radiance.z;
+}
+
+PCL_END
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <agz-utils/math.h>
+#include <agz-utils/misc.h>
+#include <agz-utils/texture.h>
+
+#define PCL_BEGIN namespace pcl {
+#define PCL_END   }
+
+PCL_BEGIN
+
+using Int2 = agz::math::vec2i;
+using Int3 = agz::math::vec3i;
+
+using Float2 = agz::math::vec2f;
+using Float3 = agz::math::vec3f;
+using Float4 = agz::math::vec4f;
+using Color4 = agz::math::color4f;
+
+template<typename T>
+using Image2D = agz::texture::texture2d_t<T>;
+
+class PCLException : public std::runtime_error
+{
+public:
+
+    using runtime_error::runtime_error;
+};
+
+PCL_END
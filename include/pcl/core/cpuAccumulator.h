@@ -0,0 +1,171 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief cpu counterpart of Accumulator, keeping the running mean of frames
+ *
+ * frames are summed in double precision, so that long renders do not drift,
+ * and the mean is only resolved when getAccumulatedOutput is called. the
+ * variance of every pixel's luminance is tracked with welford's
+ * algorithm. when adaptive sampling is enabled, pixels are removed from the
+ * active mask once the relative standard errors of all pixels in their 5x5
+ * neighborhood fall below the threshold. later frames ignore inactive pixels;
+ * the tracer is expected to skip them.
+ */
+class CpuAccumulator : public agz::misc::uncopyable_t
+{
+public:
+
+    CpuAccumulator(int width, int height);
+
+    void setSize(int width, int height);
+
+    /**
+     * @brief pixels converge once they have minFrameCount frames and the
+     *  errors of their neighborhood are at most errorThreshold.
+     *  errorThreshold <= 0 disables adaptive sampling, i.e. every pixel stays
+     *  active.
+     */
+    void setAdaptiveSampling(float errorThreshold, int minFrameCount) noexcept;
+
+    void clearHistory();
+
+    /**
+     * @brief add the pixels of frame which are in the active mask
+     */
+    void addNewFrame(const Image2D<Float4> &frame);
+
+    /**
+     * @brief add value to the row-major pixel i of the current frame
+     *
+     * only rgb is summed; the alpha of getPixelMean is always 1.
+     * different pixels may be added concurrently. finishFrame must be called
+     * after all pixels of a frame have been added. used by
+     * CpuTracer::renderAccumulated.
+     */
+    void addPixel(int i, const Float4 &value) noexcept;
+
+    void finishFrame();
+
+    /**
+     * @brief mean of all frames of row-major pixel i
+     */
+    Float4 getPixelMean(int i) const noexcept;
+
+    int getWidth() const noexcept;
+
+    int getHeight() const noexcept;
+
+    /**
+     * @brief mean of all added frames. resolved from the sums on the first
+     *  call after a change
+     */
+    const Image2D<Float4> &getAccumulatedOutput() const;
+
+    /**
+     * @brief number of frames added since the last clear
+     */
+    int getAccumulatedFrameCount() const noexcept;
+
+    int getPixelFrameCount(int x, int y) const noexcept;
+
+    /**
+     * @brief relative standard error of the mean luminance of a pixel.
+     *  infinite before the pixel has two frames.
+     */
+    float getPixelError(int x, int y) const noexcept;
+
+    /**
+     * @brief variance of the mean luminance of every pixel, for CpuDenoiser
+     */
+    Image2D<float> computeVariance() const;
+
+    /**
+     * @brief non-zero for pixels which still need frames, row-major
+     */
+    const uint8_t *getActiveMask() const noexcept;
+
+    int getActivePixelCount() const noexcept;
+
+    bool isConverged() const noexcept;
+
+    /**
+     * @brief estimated number of pixel frames until all active pixels
+     *  converge, assuming errors decrease as 1 / sqrt(frame count). every
+     *  pixel is capped at maxFrameCount frames.
+     */
+    double estimateRemainingPixelFrames(int maxFrameCount) const noexcept;
+
+private:
+
+    void updateActiveMask();
+
+    float computeError(int i) const noexcept;
+
+    double getMeanLuminance(int i) const noexcept;
+
+    int width_;
+    int height_;
+
+    // rgb per pixel. frames are opaque, so the mean alpha is 1
+    std::vector<double> sums_;
+
+    mutable Image2D<Float4> mean_;
+    mutable bool            isMeanResolved_;
+
+    std::vector<int>     frameCounts_;
+    std::vector<uint8_t> activeMask_;
+
+    // double like sums_, so that the error test does not drift either
+    std::vector<double> luminanceM2_;
+
+    // temporary buffers of updateActiveMask
+    std::vector<float> errors_;
+    std::vector<float> neighborErrors_;
+
+    int accumulatedCount_;
+    int activePixelCount_;
+
+    float errorThreshold_;
+    int   minFrameCount_;
+};
+
+inline int CpuAccumulator::getWidth() const noexcept
+{
+    return width_;
+}
+
+inline int CpuAccumulator::getHeight() const noexcept
+{
+    return height_;
+}
+
+inline int CpuAccumulator::getPixelFrameCount(int x, int y) const noexcept
+{
+    return frameCounts_[y * width_ + x];
+}
+
+inline float CpuAccumulator::getPixelError(int x, int y) const noexcept
+{
+    return computeError(y * width_ + x);
+}
+
+inline const uint8_t *CpuAccumulator::getActiveMask() const noexcept
+{
+    return activeMask_.data();
+}
+
+inline int CpuAccumulator::getActivePixelCount() const noexcept
+{
+    return activePixelCount_;
+}
+
+inline bool CpuAccumulator::isConverged() const noexcept
+{
+    return activePixelCount_ == 0;
+}
+
+PCL_END
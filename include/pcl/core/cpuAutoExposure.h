@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+
+#include <pcl/core/cpuAccumulator.h>
+#include <pcl/core/threadPool.h>
+
+PCL_BEGIN
+
+/**
+ * @brief picks the exposure of CpuToneMapper from accumulated output
+ *
+ * a log2-luminance histogram of the accumulated means is built by per-thread
+ * histograms merged after a parallel pass. pixels between the low and high
+ * luminance percentiles are averaged in log space, and the target exposure
+ * maps that average to middle grey, so dark backgrounds and small highlights
+ * do not skew it.
+ *
+ * update rebuilds the histogram only every few frames and moves the exposure
+ * towards the target exponentially in log space, so that it neither costs a
+ * pass per frame nor flickers while the noise converges.
+ */
+class CpuAutoExposure : public agz::misc::uncopyable_t
+{
+public:
+
+    static constexpr int   DEFAULT_UPDATE_INTERVAL  = 16;
+    static constexpr float DEFAULT_LOW_PERCENTILE   = 0.5f;
+    static constexpr float DEFAULT_HIGH_PERCENTILE  = 0.95f;
+    static constexpr float DEFAULT_ADAPTATION_SPEED = 2;
+
+    /**
+     * @param threadPool builds the histogram. must outlive the object.
+     */
+    explicit CpuAutoExposure(ThreadPool &threadPool);
+
+    /**
+     * @brief number of frames between histogram rebuilds in update
+     */
+    void setUpdateInterval(int frameCount) noexcept;
+
+    /**
+     * @brief luminance percentiles in [0, 1] averaged by the target
+     */
+    void setPercentiles(float low, float high) noexcept;
+
+    /**
+     * @brief the distance to the target exposure in stops shrinks by a
+     *  factor of e every 1 / speed seconds. non-positive values disable
+     *  smoothing.
+     */
+    void setAdaptationSpeed(float speed) noexcept;
+
+    /**
+     * @brief forget the smoothed exposure. the next update rebuilds the
+     *  histogram and jumps to its target.
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief advance by one frame
+     *
+     * @param elapsedSeconds time since the last update
+     *
+     * @return smoothed exposure
+     */
+    float update(const CpuAccumulator &accumulator, float elapsedSeconds);
+
+    float getExposure() const noexcept;
+
+    /**
+     * @brief exposure mapping the percentile average of accumulator to
+     *  middle grey. 1 when no pixel has been accumulated.
+     */
+    float computeTargetExposure(const CpuAccumulator &accumulator);
+
+private:
+
+    static constexpr int BIN_COUNT = 256;
+
+    using Histogram = std::array<uint32_t, BIN_COUNT>;
+
+    void buildHistogram(const CpuAccumulator &accumulator);
+
+    int   updateInterval_;
+    float lowPercentile_;
+    float highPercentile_;
+    float adaptationSpeed_;
+
+    int   framesToUpdate_;
+    bool  hasExposure_;
+    float logExposure_;
+    float logTarget_;
+
+    std::vector<Histogram> threadHistograms_;
+    Histogram              histogram_;
+
+    ThreadPool &threadPool_;
+};
+
+PCL_END
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <pcl/core/fastMath.h>
+#include <pcl/core/jensenMaterial.h>
+#include <pcl/core/jensenRhoDt.h>
+#include <pcl/core/pathSampler.h>
+
+PCL_BEGIN
+
+/*
+ * cpu port of asset/diffuse.hlsl and asset/jensen.hlsl. random numbers are
+ * passed in as a BSDFSample drawn from a PathSampler, see pathSampler.h for
+ * the port of random.hlsl. asin and exp are replaced by the approximations in
+ * fastMath.h, and cpuBSDFBatch.h evaluates the direction dependent kernels
+ * for a whole packet. keep these in sync with the shaders.
+ */
+
+constexpr float BSDF_PI = 3.1415926535f;
+
+constexpr float JENSEN_EPS = 0.01f;
+
+constexpr float DIFFUSE_REFL_PDF = 0.85f;
+
+/**
+ * @brief trilinear sampler of the rho_dt table
+ *
+ * matches JensenRhoDt.SampleLevel(JensenLinearSampler, ...) with clamp
+ * addressing.
+ */
+class JensenRhoDtSampler
+{
+public:
+
+    JensenRhoDtSampler()
+        : JensenRhoDtSampler(getJensenRhoDt())
+    {
+
+    }
+
+    explicit JensenRhoDtSampler(std::shared_ptr<const JensenRhoDt> table)
+        : table_(std::move(table)),
+          size_(table_->getSize()), data_(table_->getData())
+    {
+
+    }
+
+    const std::shared_ptr<const JensenRhoDt> &getTable() const noexcept
+    {
+        return table_;
+    }
+
+    float sample(float x, float y, float z) const noexcept
+    {
+        const int N = size_;
+
+        auto locate = [N](float c, int *i0, int *i1, float *t)
+        {
+            const float fc = c * N - 0.5f;
+            const float fl = std::floor(fc);
+            *t  = fc - fl;
+            *i0 = agz::math::clamp(static_cast<int>(fl), 0, N - 1);
+            *i1 = agz::math::clamp(static_cast<int>(fl) + 1, 0, N - 1);
+        };
+
+        int x0, x1, y0, y1, z0, z1;
+        float tx, ty, tz;
+        locate(x, &x0, &x1, &tx);
+        locate(y, &y0, &y1, &ty);
+        locate(z, &z0, &z1, &tz);
+
+        auto at = [&](int xi, int yi, int zi)
+        {
+            return data_[(size_t(zi) * N + yi) * N + xi];
+        };
+
+        auto lerp = [](float a, float b, float t) { return a + t * (b - a); };
+
+        const float c00 = lerp(at(x0, y0, z0), at(x1, y0, z0), tx);
+        const float c10 = lerp(at(x0, y1, z0), at(x1, y1, z0), tx);
+        const float c01 = lerp(at(x0, y0, z1), at(x1, y0, z1), tx);
+        const float c11 = lerp(at(x0, y1, z1), at(x1, y1, z1), tx);
+
+        return lerp(lerp(c00, c10, ty), lerp(c01, c11, ty), tz);
+    }
+
+private:
+
+    std::shared_ptr<const JensenRhoDt> table_;
+
+    int          size_;
+    const float *data_;
+};
+
+/**
+ * @brief cosine-weighted direction in the upper hemisphere from a 2d sample
+ */
+inline Float3 diffuseSampleZWeightedHemisphere(const Float2 &u) noexcept
+{
+    const float u1 = 2 * u.x - 1;
+    const float u2 = 2 * u.y - 1;
+    float samX = 0, samY = 0;
+
+    if(u1 != 0 || u2 != 0)
+    {
+        // theta is pi/4 * u2/u1 or pi/2 - pi/4 * u1/u2. the latter is
+        // evaluated with swapped sin and cos, so that the angle passed to
+        // fastSinCos stays within [-pi/4, pi/4].
+
+        float s, c;
+        if(std::abs(u1) > std::abs(u2))
+        {
+            fastSinCos(0.25f * BSDF_PI * (u2 / u1), &s, &c);
+            samX = u1 * c;
+            samY = u1 * s;
+        }
+        else
+        {
+            fastSinCos(0.25f * BSDF_PI * (u1 / u2), &s, &c);
+            samX = u2 * s;
+            samY = u2 * c;
+        }
+    }
+
+    const float z = std::sqrt((std::max)(0.0f, 1 - samX * samX - samY * samY));
+    return { samX, samY, z };
+}
+
+/**
+ * @brief random numbers of one bsdf sample
+ *
+ * they are drawn before any bsdf of a packet is sampled, so that the
+ * cosine-weighted directions of all lanes can be computed at once by
+ * diffuseSampleZWeightedHemisphereBatch.
+ */
+struct BSDFSample
+{
+    float  lobe      = 0; // side of the diffuse bsdf, jensen strategy
+    float  component = 0; // jensen hg component
+    Float2 dir;
+    Float3 cosineDir;     // diffuseSampleZWeightedHemisphere(dir)
+};
+
+/**
+ * @brief picks the side by sample.lobe and uses sample.cosineDir
+ */
+inline void sampleDiffuse(
+    float reflectionRatio,
+    bool isFront, [[maybe_unused]] const Float3 &wo,
+    const BSDFSample &sample,
+    Float3 *coef, Float3 *wi) noexcept
+{
+    const bool isReflection = sample.lobe < DIFFUSE_REFL_PDF;
+
+    Float3 samDir = sample.cosineDir;
+    if(isFront == isReflection)
+        samDir.z = -samDir.z;
+
+    *wi = samDir;
+
+    const float v = isReflection ?
+        reflectionRatio / DIFFUSE_REFL_PDF :
+        (1 - reflectionRatio) / (1 - DIFFUSE_REFL_PDF);
+    *coef = Float3(v);
+}
+
+/**
+ * @brief bsdf value of the diffuse paper for directions wo and wi
+ */
+inline Float3 evalDiffuse(
+    float reflectionRatio, const Float3 &wo, const Float3 &wi) noexcept
+{
+    const bool isReflection = wo.z * wi.z > 0;
+    return Float3(
+        (isReflection ? reflectionRatio : 1 - reflectionRatio) / BSDF_PI);
+}
+
+/**
+ * @brief solid angle pdf of sampleDiffuse generating wi from wo
+ */
+inline float pdfDiffuse(const Float3 &wo, const Float3 &wi) noexcept
+{
+    const bool isReflection = wo.z * wi.z > 0;
+    return (isReflection ? DIFFUSE_REFL_PDF : 1 - DIFFUSE_REFL_PDF)
+         * std::abs(wi.z) / BSDF_PI;
+}
+
+inline float jensenSqr(float x) noexcept { return x * x; }
+
+inline float jensenDGGX(float cosThetaH, float m) noexcept
+{
+    return m * m /
+        (BSDF_PI * jensenSqr(1 + (jensenSqr(m) - 1) * jensenSqr(cosThetaH)));
+}
+
+inline float jensenSmithGGX(float tanTheta, float m) noexcept
+{
+    const float root = m * tanTheta;
+    return 2 / (1 + std::sqrt(1 + root * root));
+}
+
+inline float jensenFresnel(float eta, float cosTheta) noexcept
+{
+    if(cosTheta < 0)
+    {
+        cosTheta = -cosTheta;
+        eta = 1 / eta;
+    }
+
+    const float sinTheta  = std::sqrt(
+        (std::max)(0.0f, 1 - cosTheta * cosTheta));
+    const float sinThetaT = sinTheta / eta;
+
+    if(sinThetaT >= 1)
+        return 1;
+
+    const float cosThetaT = std::sqrt(
+        (std::max)(0.0f, 1 - sinThetaT * sinThetaT));
+    const float para = (eta * cosTheta - cosThetaT)
+                     / (eta * cosTheta + cosThetaT);
+    const float perp = (cosTheta - eta * cosThetaT)
+                     / (cosTheta + eta * cosThetaT);
+
+    return 0.5f * (para * para + perp * perp);
+}
+
+inline float jensenTanTheta(const Float3 &w) noexcept
+{
+    const float t = 1 - w.z * w.z;
+    return std::sqrt((std::max)(t, 0.0f)) / w.z;
+}
+
+inline Float3 jensenDirectReflection(
+    const Float3 &wi, const Float3 &wo, float eta, float m) noexcept
+{
+    const Float3 wh = (wi + wo).normalize();
+    const float D = jensenDGGX(wh.z, m);
+    const float F = jensenFresnel(eta, dot(wi, wh));
+    const float G = jensenSmithGGX(jensenTanTheta(wi), m) *
+                    jensenSmithGGX(jensenTanTheta(wo), m);
+
+    return Float3(D * F * G / (4 * wi.z * wo.z));
+}
+
+inline float jensenHG(float cosIO, float g) noexcept
+{
+    const float g2  = g * g;
+    const float dem = 1 + g2 - 2 * g * cosIO;
+    return (1 - g2) / (4 * BSDF_PI * dem * std::sqrt(dem));
+}
+
+inline float jensenP(float cosIO, const Float4 &HGArg) noexcept
+{
+    return HGArg.x * jensenHG(cosIO, HGArg.y) +
+           HGArg.z * jensenHG(cosIO, HGArg.w);
+}
+
+inline float jensenAccessRhoDt(
+    const JensenRhoDtSampler &rhoDt,
+    const Float3 &wi, float eta, float m) noexcept
+{
+    const float theta = fastAsin(agz::math::clamp(std::abs(wi.z), 0.0f, 1.0f));
+    const float u = theta / (0.5f * BSDF_PI);
+    const float v = (eta - JENSEN_RHO_DT_MIN_ETA) /
+                    (JENSEN_RHO_DT_MAX_ETA - JENSEN_RHO_DT_MIN_ETA);
+    const float w = m;
+    return rhoDt.sample(w, v, u);
+}
+
+inline Float3 jensenScatteredReflection(
+    const JensenRhoDtSampler &rhoDt,
+    const Float3 &wi, const Float3 &wo,
+    float eta, float m, const Float3 &Rd) noexcept
+{
+    const float atti = jensenAccessRhoDt(rhoDt, wi, eta, m);
+    const float atto = jensenAccessRhoDt(rhoDt, wo, eta, m);
+    return atti * atto * (Rd / BSDF_PI);
+}
+
+/**
+ * @brief jensenSingleScattered for a given phase function value
+ *  singleP = jensenP(dot(wi, wo), params.HGArg)
+ */
+inline float jensenSingleScattered(
+    const Float3 &wi, const Float3 &wo,
+    const JensenMaterial &params, float singleP) noexcept
+{
+    if(std::abs(wi.z + wo.z) < JENSEN_EPS)
+    {
+        const float e = fastExp(-params.tauD / std::abs(wo.z));
+        return std::abs(
+            params.alpha * params.tauD * singleP * e / (wi.z * wo.z));
+    }
+
+    const float e = fastExp(-params.tauD / std::abs(wi.z))
+                  - fastExp(-params.tauD / std::abs(wo.z));
+    return std::abs(
+        params.alpha * singleP * e / (std::abs(wi.z) - std::abs(wo.z)));
+}
+
+inline float jensenSingleScattered(
+    const Float3 &wi, const Float3 &wo, const JensenMaterial &params) noexcept
+{
+    return jensenSingleScattered(
+        wi, wo, params, jensenP(dot(wi, wo), params.HGArg));
+}
+
+inline Float3 jensenScatteredTransmission(
+    const JensenRhoDtSampler &rhoDt,
+    const Float3 &wi, const Float3 &wo,
+    const JensenMaterial &params) noexcept
+{
+    float atti, atto;
+    if(wi.z < 0)
+    {
+        atti = jensenAccessRhoDt(rhoDt, wi, params.etaFront, params.mFront);
+        atto = jensenAccessRhoDt(rhoDt, wo, params.etaBack, params.mBack);
+    }
+    else
+    {
+        atti = jensenAccessRhoDt(rhoDt, wi, params.etaBack, params.mBack);
+        atto = jensenAccessRhoDt(rhoDt, wo, params.etaFront, params.mFront);
+    }
+
+    const float  singleScattered = jensenSingleScattered(wi, wo, params);
+    const Float3 multiScattered  = params.Td / BSDF_PI;
+
+    return atti * atto * (Float3(singleScattered) + multiScattered);
+}
+
+inline Float3 jensenEvalLobe(
+    const JensenRhoDtSampler &rhoDt,
+    const JensenMaterial &params,
+    const Float3 &wo, const Float3 &wi, bool isReflection) noexcept
+{
+    const bool isFront = wo.z < 0;
+
+    if(!isReflection)
+        return jensenScatteredTransmission(rhoDt, wi, wo, params);
+
+    if(isFront)
+    {
+        const Float3 directRefl = jensenDirectReflection(
+            -wi, -wo, params.etaFront, params.mFront);
+        const Float3 scatterRefl = jensenScatteredReflection(
+            rhoDt, -wi, -wo, params.etaFront, params.mFront, params.Rd);
+        return directRefl + scatterRefl;
+    }
+
+    const Float3 directRefl = jensenDirectReflection(
+        wi, wo, params.etaBack, params.mBack);
+    const Float3 scatterRefl = jensenScatteredReflection(
+        rhoDt, wi, wo, params.etaBack, params.mBack, params.Rd);
+    return directRefl + scatterRefl;
+}
+
+/**
+ * @brief bsdf value of the jensen paper for directions wo and wi
+ */
+inline Float3 evalJensen(
+    const JensenRhoDtSampler &rhoDt,
+    const JensenMaterial &params,
+    const Float3 &wo, const Float3 &wi) noexcept
+{
+    return jensenEvalLobe(rhoDt, params, wo, wi, wo.z * wi.z > 0);
+}
+
+PCL_END
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <pcl/core/cpuBSDF.h>
+#include <pcl/core/packetTraversal.h>
+
+PCL_BEGIN
+
+/*
+ * batched versions of the direction dependent kernels in cpuBSDF.h. every
+ * call evaluates BSDF_BATCH_SIZE lanes stored as separate float arrays, with
+ * the AVX-512 or AVX2 instructions also used by packet traversal and a loop
+ * over the scalar kernels otherwise.
+ *
+ * the simd versions use the same approximations as the scalar ones, i.e. the
+ * error bounds in fastMath.h: asin <= 6.8e-5 absolute, sin/cos <= 4e-7
+ * absolute. all other terms are exact up to rounding. lanes which are not
+ * used may hold any value, their results are unspecified.
+ */
+
+/**
+ * @brief one lane per ray of a packet
+ */
+constexpr int BSDF_BATCH_SIZE = RAY_PACKET_SIZE;
+
+/**
+ * @brief jensenFresnel(eta[i], cosTheta[i])
+ */
+void jensenFresnelBatch(
+    const float *eta, const float *cosTheta, float *result) noexcept;
+
+/**
+ * @brief jensenDGGX(cosThetaH[i], m[i])
+ */
+void jensenDGGXBatch(
+    const float *cosThetaH, const float *m, float *result) noexcept;
+
+/**
+ * @brief jensenSmithGGX(tanTheta[i], m[i])
+ */
+void jensenSmithGGXBatch(
+    const float *tanTheta, const float *m, float *result) noexcept;
+
+/**
+ * @brief jensenHG(cosIO[i], g[i])
+ */
+void jensenHGBatch(
+    const float *cosIO, const float *g, float *result) noexcept;
+
+/**
+ * @brief jensenAccessRhoDt(rhoDt, wi, eta[i], m[i]) with wi.z = cosTheta[i]
+ */
+void jensenAccessRhoDtBatch(
+    const JensenRhoDtSampler &rhoDt,
+    const float *cosTheta, const float *eta, const float *m,
+    float *result) noexcept;
+
+/**
+ * @brief diffuseSampleZWeightedHemisphere({ u1[i], u2[i] })
+ */
+void diffuseSampleZWeightedHemisphereBatch(
+    const float *u1, const float *u2,
+    float *x, float *y, float *z) noexcept;
+
+PCL_END
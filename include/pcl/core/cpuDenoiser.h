@@ -0,0 +1,82 @@
+#pragma once
+
+#include <pcl/core/threadPool.h>
+
+PCL_BEGIN
+
+/**
+ * @brief features of the primary ray of a pixel, written by CpuTracer
+ */
+struct DenoiserFeature
+{
+    // index of the first hit paper. paper count for the back light and -1
+    // when no paper is hit.
+    int layer = -1;
+
+    // paper color at the first hit, 1 when no paper is hit
+    Float3 albedo = Float3(1);
+
+    // z of the first hit
+    float depth = 0;
+};
+
+/**
+ * @brief edge-avoiding a-trous wavelet filter for accumulated cpu output
+ *
+ * see "spatiotemporal variance-guided filtering" by schied et al. the color
+ * is divided by the first-hit albedo, filtered with increasing step sizes
+ * and modulated again. taps on another layer are rejected, so cut boundaries
+ * stay sharp; depth, albedo and luminance differences relative to the noise
+ * level further reduce tap weights.
+ */
+class CpuDenoiser : public agz::misc::uncopyable_t
+{
+public:
+
+    /**
+     * @param threadPool runs the filter passes. must outlive the object.
+     */
+    explicit CpuDenoiser(ThreadPool &threadPool);
+
+    /**
+     * @brief number of wavelet levels. level i uses a step size of 2^i.
+     */
+    void setIterationCount(int count) noexcept;
+
+    /**
+     * @brief luminance differences are scaled by the standard deviation of
+     *  the center pixel times sigma
+     */
+    void setLuminanceSigma(float sigma) noexcept;
+
+    /**
+     * @param color    accumulated output
+     * @param variance variance of the mean luminance of every pixel
+     * @param features features of the primary rays
+     */
+    const Image2D<Float4> &denoise(
+        const Image2D<Float4>          &color,
+        const Image2D<float>           &variance,
+        const Image2D<DenoiserFeature> &features);
+
+private:
+
+    void filterRow(int y, int step) noexcept;
+
+    float filterVariance(int x, int y, int layer) const noexcept;
+
+    int   iterationCount_;
+    float luminanceSigma_;
+
+    const Image2D<DenoiserFeature> *features_;
+
+    // rgb: irradiance, a: variance of its luminance
+    Image2D<Float4> ping_;
+    Image2D<Float4> pong_;
+
+    Image2D<Float4> output_;
+
+    ThreadPool &threadPool_;
+};
+
+PCL_END
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief cpu counterpart of ToneMapper (asset/tonemap.hlsl)
+ *
+ * the gamma curve is encoded by a lookup table, and results may differ from
+ * the exact curve by one in the last bit.
+ */
+class CpuToneMapper : public agz::misc::uncopyable_t
+{
+public:
+
+    CpuToneMapper();
+
+    void setExposure(float exposure) noexcept;
+
+    Image2D<agz::math::color3b> render(const Image2D<Float4> &hdrImg) const;
+
+    /**
+     * @brief tone map count pixels into packed rgba8 texels
+     *
+     * r is in the lowest byte, so the texels can be uploaded as
+     * DXGI_FORMAT_R8G8B8A8_UNORM. alpha is always 255.
+     */
+    void mapRGBA8(
+        const Float4 *hdr, uint32_t *rgba, int count) const noexcept;
+
+private:
+
+    float exposure_;
+};
+
+PCL_END
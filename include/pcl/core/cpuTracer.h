@@ -0,0 +1,339 @@
+#pragma once
+
+#include <pcl/core/backLightSampler.h>
+#include <pcl/core/cpuAccumulator.h>
+#include <pcl/core/cpuDenoiser.h>
+#include <pcl/core/cpuToneMapper.h>
+#include <pcl/core/jensenSampling.h>
+#include <pcl/core/packetTraversal.h>
+#include <pcl/core/pathStatistics.h>
+#include <pcl/core/renderBackend.h>
+#include <pcl/core/threadPool.h>
+
+PCL_BEGIN
+
+/**
+ * @brief multithreaded cpu implementation of asset/tracing.hlsl
+ *
+ * has the same interface as Tracer. the output image is split into tiles
+ * which are scheduled over all workers of a work-stealing thread pool.
+ * within a tile, paths of RAY_PACKET_SIZE horizontally adjacent pixels are
+ * traced together, and hollow planes are skipped by traversePacket.
+ * paper occupancy is stored as bit-planes, and additionally as per-texel
+ * columns over all layers and as an occupancy pyramid, so that runs of hollow
+ * planes can be skipped at once. the back light is additionally sampled
+ * explicitly at every scattering vertex, proportional to its luminance, and
+ * combined with bsdf sampling by mis.
+ *
+ * the path kernel is specialized on the material types present in the stack
+ * and on the camera type. the instantiation is selected at the start of every
+ * render, so the per-bounce loop has no dispatch on either.
+ */
+class CpuTracer : public RenderBackend
+{
+public:
+
+    CpuTracer(
+        const Int2 &outputSize,
+        const Int3 &paperSize,
+        float       paperDistance,
+        int         spp,
+        int         threadCount = 0);
+
+    void setPaperSize(const Int3 &paperSize) override;
+
+    void setOutputSize(const Int2 &newOutputSize) override;
+
+    void setSPP(int spp) noexcept override;
+
+    void setPaperData(int z, const Texel *data) override;
+
+    void setBackLightRadiance(const agz::math::color3f *data) override;
+
+    void setPaperDiffuse(int z, float reflectionRatio) override;
+
+    void setPaperJensen(
+        int z,
+        float gf, float gb, float wf, float wb,
+        float frontEta, float backEta,
+        float frontM, float backM,
+        float d, float sigmaS, float sigmaA,
+        const Float3 &diffusionAlbedo) override;
+
+    void setPaperDistance(float distance) noexcept override;
+
+    void setBackLightDistance(float distance) noexcept override;
+
+    void setEnvLight(const Float3 &envLight) noexcept override;
+
+    void setEyeZ(float z) noexcept override;
+
+    void render() override;
+
+    /**
+     * @brief render a frame and add it to accumulator tile by tile
+     *
+     * traced pixels are folded into the sums of accumulator while their tile
+     * is still in cache, and getOutput is not written. when display is not
+     * nullptr, the accumulated means of all pixels are also tone mapped into
+     * the packed rgba8 texels of display (see CpuToneMapper::mapRGBA8) row by
+     * row, so that only frames which are shown pay for tone mapping.
+     */
+    void renderAccumulated(
+        CpuAccumulator      &accumulator,
+        const CpuToneMapper *toneMapper = nullptr,
+        Image2D<uint32_t>   *display    = nullptr);
+
+    /**
+     * @brief output of the last render. allocated by the first render, so
+     *  that renderAccumulated does not keep a frame buffer.
+     */
+    const Image2D<Float4> &getOutput() const noexcept;
+
+    /**
+     * @brief features of the primary rays, for CpuDenoiser. primary rays go
+     *  through pixel centers, so features of all frames are identical, and
+     *  renderAccumulated only writes them in the first frame of a history.
+     */
+    const Image2D<DenoiserFeature> &getFeatures() const noexcept;
+
+    /**
+     * @brief workers of render, idle between frames. shared with the cpu
+     *  passes on accumulated output, e.g. CpuAutoExposure and CpuDenoiser.
+     */
+    ThreadPool &getThreadPool() noexcept;
+
+    static constexpr int DEFAULT_MAX_DEPTH      = 20;
+    static constexpr int DEFAULT_ROULETTE_DEPTH = 3;
+
+    /**
+     * @brief max number of ray segments of a path, i.e. scattering events
+     *  plus one. unlike MAX_DEPTH in asset/tracing.hlsl, hollow planes
+     *  crossed by a segment are not counted, so deeply cut stacks are not
+     *  cut short.
+     */
+    void setMaxDepth(int maxDepth) noexcept;
+
+    /**
+     * @brief number of scattering events after which paths are terminated by
+     *  russian roulette on their throughput
+     */
+    void setRouletteDepth(int depth) noexcept;
+
+    /**
+     * @brief evaluate jensen materials by per-layer lookup tables instead of
+     *  the analytic model
+     *
+     * tables are built by setPaperJensen, which takes a few milliseconds per
+     * layer, and need about 400KB per layer. see JensenBSDFTable.
+     */
+    void setJensenTableEnabled(bool enabled);
+
+    /**
+     * @brief rho_dt table used by jensen materials. defaults to
+     *  getJensenRhoDt()
+     */
+    void setJensenRhoDt(std::shared_ptr<const JensenRhoDt> table);
+
+    /**
+     * @brief source of random numbers. consecutive frames continue the sample
+     *  sequence of every pixel; changing the type restarts it.
+     */
+    void setSamplerType(SamplerType type) noexcept;
+
+    /**
+     * @brief index of the first sample of the next frame
+     *
+     * random numbers only depend on pixel, sample index and sampler type, so
+     * the output is identical for any thread count, and a render can be split
+     * across processes by giving each one a disjoint range of sample indices.
+     */
+    void setSampleIndex(uint32_t index) noexcept;
+
+    uint32_t getSampleIndex() const noexcept;
+
+    /**
+     * @brief only trace pixels with non-zero mask value, as given by
+     *  CpuAccumulator::getActiveMask. output of other pixels is left
+     *  unchanged. nullptr traces every pixel.
+     *
+     * the mask is row-major and must be alive until rendering finishes.
+     */
+    void setPixelMask(const uint8_t *mask) noexcept;
+
+    /**
+     * @brief statistics of all paths traced since the last clear
+     */
+    const PathStatistics &getPathStatistics() const noexcept;
+
+    void clearPathStatistics() noexcept;
+
+private:
+
+    static constexpr int TILE_SIZE = 16;
+
+    // sampler dimensions of a scattering event. every event owns the same
+    // range, so that the 2d pairs of all paths line up.
+    //  light:    texel, unused, jitter pair
+    //  bsdf:     lobe, hg component, direction pair. see BSDFSample
+    //  roulette: survival
+    static constexpr uint32_t LIGHT_DIMENSION        = 0;
+    static constexpr uint32_t BSDF_DIMENSION         = 4;
+    static constexpr uint32_t ROULETTE_DIMENSION     = 8;
+    static constexpr uint32_t DIMENSIONS_PER_SCATTER = 10;
+
+    /**
+     * @brief where renderTile puts the traced pixels. the frame goes to
+     *  output_ when accumulator is nullptr.
+     */
+    struct FrameTarget
+    {
+        CpuAccumulator              *accumulator = nullptr;
+        const CpuToneMapper         *toneMapper  = nullptr;
+        Image2D<uint32_t>           *display     = nullptr;
+    };
+
+    struct PaperMaterial
+    {
+        static const uint32_t TYPE_DIFFUSE = 1;
+        static const uint32_t TYPE_JENSEN  = 2;
+
+        uint32_t       type            = 0;
+        float          reflectionRatio = 0;
+        JensenMaterial jensen;
+    };
+
+    /**
+     * @brief material types of all solid layers, which the path kernel is
+     *  specialized on
+     */
+    enum class MaterialSet
+    {
+        Diffuse,
+        Jensen,
+        Mixed
+    };
+
+    using TracePacketFunc = void (CpuTracer::*)(
+        const PaperStackView &, const int *, int, int,
+        PathSampler *, Float4 *, DenoiserFeature *,
+        PathStatistics &) const noexcept;
+
+    template<MaterialSet Materials>
+    static bool isDiffuse(const PaperMaterial &material) noexcept;
+
+    MaterialSet getMaterialSet() const noexcept;
+
+    /**
+     * @brief instantiation of tracePacket for the current materials and
+     *  camera
+     */
+    TracePacketFunc selectTracePacket() const noexcept;
+
+    void markLayerSolid(int z) noexcept;
+
+    void updateOccupancy();
+
+    Float3 getPaperColor(int x, int y, int z) const noexcept;
+
+    /**
+     * @brief lookup table of the material of layer z, or nullptr when the
+     *  analytic model is used
+     */
+    const JensenBSDFTable *getJensenTable(int z) const noexcept;
+
+    float getBackLightZ() const noexcept;
+
+    /**
+     * @brief solid angle pdf of sampling the back light point hit by the ray
+     *  (pos, dir) in estimateBackLight
+     */
+    float getBackLightPdf(const Float3 &pos, const Float3 &dir) const noexcept;
+
+    /**
+     * @brief next-event estimation of the back light at a scattering vertex
+     *  pos on plane z, weighted against bsdf sampling with the power heuristic
+     *
+     * @param lobes sampling strategies of jensen materials at pos
+     *
+     * @return contribution without paper color and path throughput
+     */
+    template<MaterialSet Materials>
+    Float3 estimateBackLight(
+        const PaperStackView &stack, int z,
+        const Float3 &pos, const Float3 &wo,
+        const PaperMaterial &material, const JensenLobePdfs &lobes,
+        PathSampler &sampler) const noexcept;
+
+    PaperStackView getPaperStackView() const noexcept;
+
+    template<bool Perspective>
+    void generateCameraRay(
+        int x, int y, Float3 *ori, Float3 *dir) const noexcept;
+
+    /**
+     * @brief trace one path for each of pixels (xs[i], y), i < laneCount
+     *
+     * @param features features of the primary rays are written here when
+     *  not nullptr
+     */
+    template<MaterialSet Materials, bool Perspective>
+    void tracePacket(
+        const PaperStackView &stack,
+        const int *xs, int y, int laneCount,
+        PathSampler *samplers, Float4 *results,
+        DenoiserFeature *features,
+        PathStatistics &statistics) const noexcept;
+
+    void renderFrame(const FrameTarget &target);
+
+    void renderTile(
+        const PaperStackView &stack, TracePacketFunc tracePacketFunc,
+        const FrameTarget &target, int tileIndex,
+        PathStatistics &statistics) noexcept;
+
+    Int2  outputSize_;
+    Int3  paperSize_;
+    float paperDistance_;
+    float backLightDistance_;
+    int   spp_;
+    int   maxDepth_;
+    int   rouletteDepth_;
+
+    SamplerType samplerType_;
+    uint32_t    sampleIndex_;
+
+    const uint8_t *pixelMask_;
+
+    Float3 envLight_;
+    float eyeZ_;
+
+    OccupancyPlanes  occupancy_;
+    PaperColumns     columns_;
+    OccupancyPyramid pyramid_;
+
+    std::vector<bool>      dirtyColumnLayers_;
+    std::vector<TexelRect> dirtyPyramidRects_;
+
+    // paper colors are only kept for layers which are not purely white
+    std::vector<std::vector<agz::math::color3b>> paperColors_;
+
+    std::vector<PaperMaterial>   paperMaterials_;
+    std::vector<JensenBSDFTable> jensenTables_;
+    bool                         useJensenTables_;
+    std::vector<int32_t>       layerPassable_;
+    std::vector<Float3>        backLight_;
+    BackLightSampler           backLightSampler_;
+
+    JensenRhoDtSampler rhoDt_;
+
+    Image2D<Float4>          output_;
+    Image2D<DenoiserFeature> features_;
+
+    ThreadPool threadPool_;
+
+    PathStatistics              statistics_;
+    std::vector<PathStatistics> threadStatistics_;
+};
+
+PCL_END
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/*
+ * branch-free polynomial approximations of the transcendental functions used
+ * by the cpu bsdfs. they only use arithmetic, sqrt and floor, so that they are
+ * also vectorized when inlined into loops. error bounds were measured over the
+ * whole domain.
+ */
+
+/**
+ * @brief asin(x) for x in [0, 1]
+ *
+ * abramowitz & stegun 4.4.45. absolute error <= 6.8e-5.
+ */
+inline float fastAsin(float x) noexcept
+{
+    const float p = 1.5707288f + x * (-0.2121144f +
+                                 x * (0.0742610f +
+                                 x * -0.0187293f));
+    return 1.5707963f - std::sqrt((std::max)(0.0f, 1 - x)) * p;
+}
+
+/**
+ * @brief sin(x) and cos(x) for x in [-pi/4, pi/4]
+ *
+ * taylor polynomials of degree 7 and 8. absolute error <= 4e-7.
+ */
+inline void fastSinCos(float x, float *s, float *c) noexcept
+{
+    const float x2 = x * x;
+    *s = x * (1 + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040))));
+    *c = 1 + x2 * (-0.5f + x2 * (1.0f / 24 + x2 * (-1.0f / 720 +
+                                         x2 * (1.0f / 40320))));
+}
+
+/**
+ * @brief exp(x) for x <= 0
+ *
+ * 2^(x / ln2) is split into 2^i * 2^f with f in [-0.5, 0.5]. 2^f is a degree 5
+ * polynomial, and 2^i is built in the exponent bits. relative error <= 6e-6,
+ * and results for x < -87 are flushed to zero.
+ */
+inline float fastExp(float x) noexcept
+{
+    constexpr float LOG2E = 1.44269504f;
+    constexpr float MIN_X = -87.0f;
+
+    const float t = (std::max)(x, MIN_X) * LOG2E;
+    const float i = std::floor(t + 0.5f);
+    const float f = t - i;
+
+    const float p = 1.0f + f * (0.69314718f +
+                           f * (0.24022651f +
+                           f * (0.05550411f +
+                           f * (0.00961813f +
+                           f * 0.00133336f))));
+
+    const int32_t bits = (static_cast<int32_t>(i) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return x >= MIN_X ? p * scale : 0.0f;
+}
+
+PCL_END
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief precomputed coefficients of the paper model proposed by Jensen et al.
+ *
+ * shared by the gpu and cpu tracers. field layout follows JensenParams in
+ * asset/jensen.hlsl.
+ */
+struct JensenMaterial
+{
+    float  etaFront = 1;
+    float  etaBack  = 1;
+    float  mFront   = 1;
+    float  mBack    = 1;
+    Float3 Rd;
+    Float3 Td;
+    float  alpha    = 0;
+    float  tauD     = 0;
+    Float4 HGArg; // wf, gf, wb, gb
+};
+
+std::pair<Float3, Float3> computeRdAndTd(
+    int n, const Float3 &color,
+    float sigma_s, float sigma_a, float d,
+    float gf, float gb, float wf, float wb) noexcept;
+
+JensenMaterial computeJensenMaterial(
+    float gf, float gb, float wf, float wb,
+    float frontEta, float backEta,
+    float frontM, float backM,
+    float d, float sigmaS, float sigmaA,
+    const Float3 &diffusionAlbedo) noexcept;
+
+PCL_END
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+class MappedFile;
+class ThreadPool;
+
+constexpr int JENSEN_RHO_DT_DEFAULT_SIZE = 64;
+
+constexpr int JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT = 1024;
+
+/*
+ * ior range covered by the y axis of the rho_dt table
+ */
+constexpr float JENSEN_RHO_DT_MIN_ETA = 1.01f;
+constexpr float JENSEN_RHO_DT_MAX_ETA = 10.0f;
+
+/**
+ * @brief rho_dt table with size^3 texels
+ *
+ * x (fastest) is roughness, y is ior and z is incident elevation angle. each
+ * texel stores 1 minus the directional albedo of the ggx reflection lobe,
+ * sampled at the texel center.
+ *
+ * the table either owns its data or maps a cache file written by
+ * saveJensenRhoDt.
+ */
+class JensenRhoDt : public agz::misc::uncopyable_t
+{
+public:
+
+    JensenRhoDt(int size, int sampleCount, std::vector<float> data);
+
+    /**
+     * @brief map a cache file. throws PCLException when it is invalid
+     */
+    explicit JensenRhoDt(const std::string &cacheFilename);
+
+    ~JensenRhoDt();
+
+    int getSize() const noexcept;
+
+    /**
+     * @brief ggx normal samples per texel, see computeJensenRhoDt
+     */
+    int getSampleCount() const noexcept;
+
+    const float *getData() const noexcept;
+
+private:
+
+    int          size_;
+    int          sampleCount_;
+    const float *data_;
+
+    std::vector<float>          ownedData_;
+    std::unique_ptr<MappedFile> mappedFile_;
+};
+
+/**
+ * @brief compute the size^3 rho_dt texels
+ *
+ * each texel is estimated with sampleCount stratified ggx normal samples.
+ * rows of the table are distributed over the thread pool.
+ */
+std::vector<float> computeJensenRhoDt(
+    int size, int sampleCount, ThreadPool &threadPool);
+
+/**
+ * @brief write a rho_dt cache file
+ *
+ * the file is written to a temporary path first and then renamed, so that
+ * readers never see a partial table. throws PCLException on failure.
+ */
+void saveJensenRhoDt(
+    const std::string &filename, int size, int sampleCount, const float *data);
+
+/**
+ * @brief default cache path of a rho_dt table of given size
+ */
+std::string getJensenRhoDtCacheFilename(int size);
+
+/**
+ * @brief get the shared rho_dt table of given size
+ *
+ * loaded tables are kept for the lifetime of the process. a cache file
+ * which is missing, invalid or computed with fewer than
+ * JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT samples is regenerated with all
+ * hardware threads.
+ */
+std::shared_ptr<const JensenRhoDt> getJensenRhoDt(
+    int size = JENSEN_RHO_DT_DEFAULT_SIZE);
+
+PCL_END
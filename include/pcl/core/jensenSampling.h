@@ -0,0 +1,79 @@
+#pragma once
+
+#include <pcl/core/jensenTable.h>
+
+PCL_BEGIN
+
+/*
+ * lobe-aware importance sampling of the jensen paper bsdf for the cpu tracer.
+ * evaluation is shared with the shader port in cpuBSDF.h; only the choice of
+ * directions differs from sampleJensen in asset/jensen.hlsl.
+ */
+
+/**
+ * @brief selection probabilities of the sampling strategies for a given wo
+ *
+ * all strategies are combined by one-sample mis with the balance heuristic,
+ * i.e. the pdf of a direction is the mixture of the pdfs of all strategies.
+ * the cosine-weighted strategies always keep a minimal probability so that
+ * every direction with a non-zero bsdf value can be sampled.
+ */
+struct JensenLobePdfs
+{
+    float specular     = 0; // ggx normal distribution reflection
+    float reflection   = 0; // cosine-weighted reflection
+    float transmission = 0; // cosine-weighted transmission
+    float single       = 0; // henyey-greenstein single scattering
+};
+
+/**
+ * @brief parameters of the side of the paper wo lies on, as used by
+ *  jensenEvalLobe for both reflection and transmission
+ */
+inline void getJensenOutgoingSide(
+    const JensenMaterial &params, const Float3 &wo,
+    float *eta, float *m) noexcept
+{
+    const bool isFront = wo.z < 0;
+    *eta = isFront ? params.etaFront : params.etaBack;
+    *m   = isFront ? params.mFront   : params.mBack;
+}
+
+/**
+ * @brief choose lobe probabilities proportional to estimated lobe albedos
+ *
+ * @param fresnel jensenFresnel(eta, |wo.z|)
+ * @param atto    jensenAccessRhoDt(rhoDt, wo, eta, m)
+ *
+ * with eta and m given by getJensenOutgoingSide. both are taken as
+ * arguments, so that they can be evaluated for a whole packet at once.
+ */
+JensenLobePdfs computeJensenLobePdfs(
+    const JensenMaterial &params, float fresnel, float atto) noexcept;
+
+/**
+ * @brief solid angle pdf of sampleJensenLobes generating wi from wo
+ */
+float pdfJensenLobes(
+    const JensenMaterial &params, const JensenLobePdfs &lobes,
+    const Float3 &wo, const Float3 &wi) noexcept;
+
+/**
+ * @brief sample wi from wo with the strategies given by lobes
+ *
+ * sample.lobe picks the strategy and sample.component the hg lobe. the ggx
+ * and hg strategies use sample.dir, and the cosine-weighted ones
+ * sample.cosineDir.
+ *
+ * @param table evaluates the bsdf instead of evalJensen when not nullptr
+ * @param coef  bsdf * |cos| / pdf of the sampled direction
+ * @param pdf   solid angle pdf of wi. 0 when the chosen strategy produced a
+ *  direction on the wrong side of the paper, in which case coef is 0.
+ */
+void sampleJensenLobes(
+    const JensenRhoDtSampler &rhoDt, const JensenBSDFTable *table,
+    const JensenMaterial &params, const JensenLobePdfs &lobes,
+    const Float3 &wo, const BSDFSample &sample,
+    Float3 *coef, Float3 *wi, float *pdf) noexcept;
+
+PCL_END
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <pcl/core/cpuBSDF.h>
+
+PCL_BEGIN
+
+/**
+ * @brief tabulated jensen paper bsdf of one material
+ *
+ * the bsdf is isotropic, so every lobe is a function of |cos(theta_i)|,
+ * |cos(theta_o)| and cos(phi_i - phi_o). direct reflection of both sides and
+ * single scattered transmission are stored on a regular grid over these
+ * coordinates, premultiplied by |cos(theta_i) * cos(theta_o)| to remove the
+ * singularity at grazing angles. rho_dt attenuation of both sides is stored
+ * over |cos(theta)|. colored terms are applied at evaluation time, so a table
+ * only depends on the scalar material parameters.
+ *
+ * evaluation replaces the asin, exp, fresnel, ggx and hg computations of
+ * evalJensen by trilinear interpolation.
+ */
+class JensenBSDFTable
+{
+public:
+
+    static constexpr int COS_THETA_SIZE = 32;
+    static constexpr int COS_PHI_SIZE   = 32;
+    static constexpr int RHO_DT_SIZE    = 256;
+
+    void build(
+        const JensenRhoDtSampler &rhoDt, const JensenMaterial &params);
+
+    void clear() noexcept;
+
+    bool isAvailable() const noexcept;
+
+    /**
+     * @brief approximation of evalJensen(rhoDt, params, wo, wi)
+     *
+     * params must be the material the table was built from
+     */
+    Float3 eval(
+        const JensenMaterial &params,
+        const Float3 &wo, const Float3 &wi) const noexcept;
+
+private:
+
+    static constexpr int FRONT = 0;
+    static constexpr int BACK  = 1;
+
+    static size_t getLobeTexelCount() noexcept;
+
+    float sampleLobe(
+        const std::vector<float> &lobe,
+        float cosI, float cosO, float cosPhi) const noexcept;
+
+    float sampleRhoDt(int side, float cosTheta) const noexcept;
+
+    std::vector<float> directReflection_[2];
+    std::vector<float> singleTransmission_;
+    std::vector<float> rhoDt_[2];
+};
+
+PCL_END
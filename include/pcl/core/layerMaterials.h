@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pcl/core/scene.h>
+
+PCL_BEGIN
+
+/**
+ * @brief tracks which layer materials a render backend is up to date with
+ *
+ * every layer remembers the hash of the parameters last sent to the backend,
+ * so that update only derives and uploads materials of layers whose
+ * parameters have actually changed, e.g. after editing or reordering layers.
+ */
+class LayerMaterials
+{
+public:
+
+    /**
+     * @brief send materials of changed layers to backend
+     *
+     * @return whether any layer was updated
+     */
+    bool update(
+        RenderBackend &backend, const std::vector<JensenParams> &params);
+
+    /**
+     * @brief forget uploaded materials, so that the next update sends all
+     *  layers. call this after the backend has been resized.
+     */
+    void invalidate() noexcept;
+
+private:
+
+    std::vector<uint64_t> uploadedHashes_;
+    std::vector<bool>     isUploaded_;
+};
+
+PCL_END
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief read-only memory mapping of a whole file
+ */
+class MappedFile : public agz::misc::uncopyable_t
+{
+public:
+
+    /**
+     * @brief throws PCLException when the file can not be mapped
+     */
+    explicit MappedFile(const std::string &filename);
+
+    ~MappedFile();
+
+    const void *getData() const noexcept;
+
+    size_t getSize() const noexcept;
+
+private:
+
+    const void *data_;
+    size_t      size_;
+
+#ifdef _WIN32
+    void *file_;
+    void *mapping_;
+#endif
+};
+
+PCL_END
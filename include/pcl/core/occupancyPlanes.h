@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+
+#include <pcl/core/paperLayer.h>
+
+PCL_BEGIN
+
+/**
+ * @brief texel range [xBeg, xEnd) x [yBeg, yEnd) of a paper layer
+ */
+struct TexelRect
+{
+    int xBeg = 0;
+    int yBeg = 0;
+    int xEnd = 0;
+    int yEnd = 0;
+
+    bool isEmpty() const noexcept
+    {
+        return xBeg >= xEnd || yBeg >= yEnd;
+    }
+
+    void merge(const TexelRect &rhs) noexcept
+    {
+        if(rhs.isEmpty())
+            return;
+        if(isEmpty())
+        {
+            *this = rhs;
+            return;
+        }
+        xBeg = (std::min)(xBeg, rhs.xBeg);
+        yBeg = (std::min)(yBeg, rhs.yBeg);
+        xEnd = (std::max)(xEnd, rhs.xEnd);
+        yEnd = (std::max)(yEnd, rhs.yEnd);
+    }
+};
+
+/**
+ * @brief bit-packed occupancy of a paper stack
+ *
+ * each layer is stored as a bit-plane with one bit per texel, set when the
+ * texel is solid. every row starts at a new 64-bit word, so that bit x of row
+ * y in layer z is bit (x & 63) of word getWordIndex(x, y, z).
+ */
+class OccupancyPlanes
+{
+public:
+
+    static constexpr int BITS_PER_WORD = 64;
+
+    OccupancyPlanes() noexcept;
+
+    OccupancyPlanes(int width, int height, int layerCount);
+
+    /**
+     * @brief resize the stack. all texels become hollow.
+     */
+    void resize(int width, int height, int layerCount);
+
+    /**
+     * @return texels whose occupancy has changed, rounded out to whole words
+     */
+    TexelRect setLayer(int z, const PaperTexel *data) noexcept;
+
+    TexelRect setLayer(int z, const Image2D<uint8_t> &binary) noexcept;
+
+    void clearLayer(int z) noexcept;
+
+    int getWidth() const noexcept;
+
+    int getHeight() const noexcept;
+
+    int getLayerCount() const noexcept;
+
+    int getWordsPerRow() const noexcept;
+
+    size_t getWordIndex(int x, int y, int z) const noexcept;
+
+    bool isSolid(int x, int y, int z) const noexcept;
+
+    const uint64_t *getRow(int y, int z) const noexcept;
+
+    const uint64_t *getData() const noexcept;
+
+private:
+
+    uint64_t *getMutableRow(int y, int z) noexcept;
+
+    int width_;
+    int height_;
+    int layerCount_;
+    int wordsPerRow_;
+
+    std::vector<uint64_t> words_;
+};
+
+inline int OccupancyPlanes::getWidth() const noexcept
+{
+    return width_;
+}
+
+inline int OccupancyPlanes::getHeight() const noexcept
+{
+    return height_;
+}
+
+inline int OccupancyPlanes::getLayerCount() const noexcept
+{
+    return layerCount_;
+}
+
+inline int OccupancyPlanes::getWordsPerRow() const noexcept
+{
+    return wordsPerRow_;
+}
+
+inline size_t OccupancyPlanes::getWordIndex(int x, int y, int z) const noexcept
+{
+    return (size_t(z) * height_ + y) * wordsPerRow_ + (x >> 6);
+}
+
+inline bool OccupancyPlanes::isSolid(int x, int y, int z) const noexcept
+{
+    return (words_[getWordIndex(x, y, z)] >> (x & 63)) & 1;
+}
+
+inline const uint64_t *OccupancyPlanes::getRow(int y, int z) const noexcept
+{
+    return &words_[(size_t(z) * height_ + y) * wordsPerRow_];
+}
+
+inline const uint64_t *OccupancyPlanes::getData() const noexcept
+{
+    return words_.data();
+}
+
+PCL_END
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <pcl/core/paperColumns.h>
+
+PCL_BEGIN
+
+enum class TileOccupancy : uint8_t
+{
+    Hollow = 0,
+    Solid  = 1,
+    Mixed  = 2
+};
+
+/**
+ * @brief per-layer min/max occupancy pyramid of a paper stack
+ *
+ * tiles of level l cover (1 << getTileShift(l))^2 texels, starting with 8x8
+ * tiles at level 0. each tile records whether it is fully hollow, fully solid
+ * or mixed in every layer.
+ *
+ * for empty-space skipping, every level also keeps tile columns: bit z of
+ * the column of a tile is set when the tile is not fully hollow in layer z
+ * and layer z is enabled (has a material).
+ *
+ * for early hits, level 0 keeps solid tile columns as well: bit z is set when
+ * the tile is fully solid in layer z and layer z is enabled, so that a ray
+ * landing in such a tile hits paper without reading its texel.
+ */
+class OccupancyPyramid
+{
+public:
+
+    static constexpr int BASE_TILE_SHIFT = 3;
+    static constexpr int MAX_LEVEL_COUNT = 6;
+
+    OccupancyPyramid() noexcept;
+
+    /**
+     * @brief resize the stack. all layers become hollow and enabled.
+     */
+    void resize(int width, int height, int layerCount);
+
+    /**
+     * @brief rebuild all tiles of layer z
+     */
+    void setLayer(int z, const OccupancyPlanes &occupancy);
+
+    /**
+     * @brief rebuild the tiles of layer z which overlap a changed region
+     */
+    void updateLayer(
+        int z, const OccupancyPlanes &occupancy, const TexelRect &dirty);
+
+    void setLayerEnabled(int z, bool enabled);
+
+    int getLevelCount() const noexcept;
+
+    int getTileShift(int level) const noexcept;
+
+    int getLevelWidth(int level) const noexcept;
+
+    int getLevelHeight(int level) const noexcept;
+
+    TileOccupancy getTile(int level, int x, int y, int z) const noexcept;
+
+    const PaperColumns &getLevelColumns(int level) const noexcept;
+
+    const PaperColumns &getSolidTileColumns() const noexcept;
+
+private:
+
+    struct Level
+    {
+        int width  = 0;
+        int height = 0;
+
+        // layer-major, then row-major
+        std::vector<TileOccupancy> tiles;
+
+        PaperColumns columns;
+    };
+
+    template<typename IsSolid>
+    void updateRegion(int z, const TexelRect &dirty, IsSolid &&isSolid);
+
+    TileOccupancy &getMutableTile(int level, int x, int y, int z) noexcept;
+
+    void updateColumnBit(int level, int x, int y, int z) noexcept;
+
+    int width_;
+    int height_;
+    int layerCount_;
+
+    std::vector<bool> layerEnabled_;
+    std::vector<Level> levels_;
+
+    PaperColumns solidTileColumns_;
+};
+
+inline int OccupancyPyramid::getLevelCount() const noexcept
+{
+    return static_cast<int>(levels_.size());
+}
+
+inline int OccupancyPyramid::getTileShift(int level) const noexcept
+{
+    return BASE_TILE_SHIFT + level;
+}
+
+inline int OccupancyPyramid::getLevelWidth(int level) const noexcept
+{
+    return levels_[level].width;
+}
+
+inline int OccupancyPyramid::getLevelHeight(int level) const noexcept
+{
+    return levels_[level].height;
+}
+
+inline TileOccupancy OccupancyPyramid::getTile(
+    int level, int x, int y, int z) const noexcept
+{
+    auto &l = levels_[level];
+    return l.tiles[(size_t(z) * l.height + y) * l.width + x];
+}
+
+inline const PaperColumns &OccupancyPyramid::getLevelColumns(
+    int level) const noexcept
+{
+    return levels_[level].columns;
+}
+
+inline const PaperColumns &
+    OccupancyPyramid::getSolidTileColumns() const noexcept
+{
+    return solidTileColumns_;
+}
+
+PCL_END
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <pcl/core/occupancyPyramid.h>
+
+#if defined(__AVX512F__)
+#define PCL_PACKET_AVX512
+#elif defined(__AVX2__)
+#define PCL_PACKET_AVX2
+#endif
+
+PCL_BEGIN
+
+/**
+ * @brief number of rays advanced together through the paper stack
+ *
+ * 16 with AVX-512, 8 with AVX2 and the scalar fallback.
+ */
+#if defined(PCL_PACKET_AVX512)
+constexpr int RAY_PACKET_SIZE = 16;
+#else
+constexpr int RAY_PACKET_SIZE = 8;
+#endif
+
+/**
+ * @brief offset applied to ray origins when leaving a plane. same as EPS in
+ *  asset/tracing.hlsl.
+ */
+constexpr float TRAVERSAL_EPS = 0.01f;
+
+/**
+ * @brief read-only view of the paper stack used by packet traversal
+ *
+ * lengths are measured in output pixels along x/y and in paper texels along z,
+ * as in asset/tracing.hlsl.
+ */
+struct PaperStackView
+{
+    // see OccupancyPlanes for the layout
+    const uint64_t *occupancy = nullptr;
+    int occupancyWordsPerRow  = 0;
+
+    // optional. only layers which are not passable may be set in columns and
+    // enabled in pyramid
+    const PaperColumns     *columns = nullptr;
+    const OccupancyPyramid *pyramid = nullptr;
+
+    // non-zero means the plane has no material and is always skipped
+    const int32_t *layerPassable = nullptr;
+
+    int paperWidth  = 0;
+    int paperHeight = 0;
+    int paperCount  = 0;
+
+    float outputWidth  = 0;
+    float outputHeight = 0;
+
+    float paperDistance     = 0;
+    float backLightDistance = 0;
+
+    int maxDepth = 0;
+};
+
+enum class TraversalEvent : int32_t
+{
+    None           = 0,
+    Escaped        = 1, // no plane in front of the ray
+    OutOfBounds    = 2, // plane hit outside of the paper rectangle
+    BackLight      = 3, // back light plane hit
+    Paper          = 4, // solid paper texel hit
+    DepthExhausted = 5  // depth exceeded maxDepth
+};
+
+/**
+ * @brief SoA ray packet. planeZ is the index of the next plane to be tested
+ *  and depth is the index of the current ray segment of the path (starting
+ *  from 1).
+ */
+struct alignas(64) RayPacket
+{
+    float oriX[RAY_PACKET_SIZE];
+    float oriY[RAY_PACKET_SIZE];
+    float oriZ[RAY_PACKET_SIZE];
+
+    float dirX[RAY_PACKET_SIZE];
+    float dirY[RAY_PACKET_SIZE];
+    float dirZ[RAY_PACKET_SIZE];
+
+    int32_t planeZ[RAY_PACKET_SIZE];
+    int32_t depth [RAY_PACKET_SIZE];
+};
+
+struct alignas(64) TraversalHits
+{
+    float inctX[RAY_PACKET_SIZE];
+    float inctY[RAY_PACKET_SIZE];
+    float inctZ[RAY_PACKET_SIZE];
+
+    int32_t paperX[RAY_PACKET_SIZE];
+    int32_t paperY[RAY_PACKET_SIZE];
+
+    TraversalEvent event[RAY_PACKET_SIZE];
+};
+
+/**
+ * @brief advance all active rays through hollow planes until each of them
+ *  produces a traversal event
+ *
+ * unlike the 'nextPlaneZ += ±1; continue;' branch of the shader, skipped
+ * planes do not consume depth; rays whose depth already exceeds maxDepth are
+ * reported as DepthExhausted. when stack.columns or stack.pyramid is given, a
+ * run of hollow planes which the ray crosses within a single texel column or
+ * pyramid tile is skipped at once, following the run over all words of the
+ * column. with stack.pyramid, a ray landing in a tile which is fully solid in
+ * its plane hits paper without reading the texel. for every active lane,
+ * packet ori and planeZ describe the plane at which the event happened, and
+ * hits holds the intersection point with it.
+ *
+ * @param activeMask bit i set means lane i is traversed
+ */
+void traversePacket(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept;
+
+/**
+ * @brief scalar reference implementation of traversePacket
+ */
+void traversePacketScalar(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept;
+
+/**
+ * @brief whether the segment from ori to a point on the back light plane only
+ *  crosses hollow texels of the solid planes in [planeZ, paperCount)
+ *
+ * used as shadow ray for next-event estimation. ori is expected to lie between
+ * plane planeZ - 1 and plane planeZ.
+ */
+bool isBackLightVisible(
+    const PaperStackView &stack, int planeZ,
+    const Float3 &ori, const Float3 &lightPos) noexcept;
+
+PCL_END
@@ -0,0 +1,189 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+
+#include <pcl/core/occupancyPlanes.h>
+
+PCL_BEGIN
+
+/**
+ * @brief per-texel bitmask over all layers of a paper stack
+ *
+ * bit z of column (x, y) is set when texel (x, y) of layer z is solid. columns
+ * longer than 64 layers span multiple words. the bits are stored as
+ * getWordsPerColumn() consecutive words per column, columns in row-major
+ * order.
+ */
+class PaperColumns
+{
+public:
+
+    static constexpr int BITS_PER_WORD = 64;
+
+    PaperColumns() noexcept;
+
+    /**
+     * @brief resize the stack. all texels become hollow.
+     */
+    void resize(int width, int height, int layerCount);
+
+    /**
+     * @brief copy layer z from bit-plane z of occupancy
+     */
+    void setLayer(int z, const OccupancyPlanes &occupancy) noexcept;
+
+    void clearLayer(int z) noexcept;
+
+    void setTexel(int x, int y, int z, bool solid) noexcept;
+
+    int getWidth() const noexcept;
+
+    int getHeight() const noexcept;
+
+    int getWordsPerColumn() const noexcept;
+
+    const uint64_t *getColumn(int x, int y) const noexcept;
+
+    const uint64_t *getData() const noexcept;
+
+    /**
+     * @brief index of the first solid layer >= z, or layer count if none
+     */
+    int findNextSolidLayer(int x, int y, int z) const noexcept;
+
+    /**
+     * @brief index of the last solid layer <= z, or -1 if none
+     */
+    int findPrevSolidLayer(int x, int y, int z) const noexcept;
+
+private:
+
+    static int countTrailingZeros(uint64_t word) noexcept;
+
+    static int findHighestBit(uint64_t word) noexcept;
+
+    int width_;
+    int height_;
+    int layerCount_;
+    int wordsPerColumn_;
+
+    std::vector<uint64_t> words_;
+};
+
+inline void PaperColumns::setTexel(int x, int y, int z, bool solid) noexcept
+{
+    uint64_t &word =
+        words_[(size_t(y) * width_ + x) * wordsPerColumn_ + (z >> 6)];
+    const uint64_t bit = uint64_t(1) << (z & 63);
+    word = solid ? (word | bit) : (word & ~bit);
+}
+
+inline int PaperColumns::getWidth() const noexcept
+{
+    return width_;
+}
+
+inline int PaperColumns::getHeight() const noexcept
+{
+    return height_;
+}
+
+inline int PaperColumns::getWordsPerColumn() const noexcept
+{
+    return wordsPerColumn_;
+}
+
+inline const uint64_t *PaperColumns::getColumn(int x, int y) const noexcept
+{
+    return &words_[(size_t(y) * width_ + x) * wordsPerColumn_];
+}
+
+inline const uint64_t *PaperColumns::getData() const noexcept
+{
+    return words_.data();
+}
+
+inline int PaperColumns::findNextSolidLayer(int x, int y, int z) const noexcept
+{
+    if(z >= layerCount_)
+        return layerCount_;
+    if(z < 0)
+        z = 0;
+
+    const uint64_t *column = getColumn(x, y);
+
+    int wordIndex = z >> 6;
+    uint64_t word = column[wordIndex] >> (z & 63);
+    if(word)
+        return (std::min)(z + countTrailingZeros(word), layerCount_);
+
+    while(++wordIndex < wordsPerColumn_)
+    {
+        if(column[wordIndex])
+        {
+            const int result =
+                wordIndex * BITS_PER_WORD +
+                countTrailingZeros(column[wordIndex]);
+            return (std::min)(result, layerCount_);
+        }
+    }
+
+    return layerCount_;
+}
+
+inline int PaperColumns::findPrevSolidLayer(int x, int y, int z) const noexcept
+{
+    if(z < 0)
+        return -1;
+    if(z >= layerCount_)
+        z = layerCount_ - 1;
+
+    const uint64_t *column = getColumn(x, y);
+
+    int wordIndex = z >> 6;
+    const int shift = 63 - (z & 63);
+    uint64_t word = (column[wordIndex] << shift) >> shift;
+    if(word)
+        return wordIndex * BITS_PER_WORD + findHighestBit(word);
+
+    while(--wordIndex >= 0)
+    {
+        if(column[wordIndex])
+        {
+            return wordIndex * BITS_PER_WORD +
+                   findHighestBit(column[wordIndex]);
+        }
+    }
+
+    return -1;
+}
+
+inline int PaperColumns::countTrailingZeros(uint64_t word) noexcept
+{
+    assert(word);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int PaperColumns::findHighestBit(uint64_t word) noexcept
+{
+    assert(word);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+PCL_END
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief texel of a paper layer as consumed by the tracers
+ *
+ * binary == 0 means the texel is cut out.
+ */
+struct PaperTexel
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    uint8_t binary;
+};
+
+/**
+ * @brief convert a loaded layer image to binary. black texels are cut out.
+ */
+Image2D<uint8_t> rgbToLayerBinary(const Image2D<agz::math::color3b> &rgb);
+
+/**
+ * @brief convert a binary layer image to tracer texels with white paper color
+ */
+Image2D<PaperTexel> binaryToTracerTexels(const Image2D<uint8_t> &tex);
+
+PCL_END
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+// see http://www.reedbeta.com/blog/quick-and-easy-gpu-random-numbers-in-d3d11/
+inline uint32_t wangHash(uint32_t seed) noexcept
+{
+    seed = (seed ^ 61) ^ (seed >> 16);
+    seed *= 9;
+    seed = seed ^ (seed >> 4);
+    seed *= 0x27d4eb2d;
+    seed = seed ^ (seed >> 15);
+    return seed;
+}
+
+enum class SamplerType : int
+{
+    Philox = 0, // independent uniform numbers
+    Sobol  = 1, // shuffled owen-scrambled sobol
+    Rank1  = 2  // rank-1 lattice with blue-noise rotation per pixel
+};
+
+/**
+ * @brief dimension-indexed random numbers of a single path
+ *
+ * the n-th call of next1D returns dimension n of sample sampleIndex of the
+ * pixel. numbers are computed statelessly from (pixel, sample index,
+ * dimension), so images do not depend on thread count or tile order.
+ *
+ * for Sobol and Rank1, dimensions 2k and 2k + 1 form a 2d point set which is
+ * stratified over consecutive sample indices. 2d quantities (e.g. hemisphere
+ * directions) must be drawn by next2D, which starts at an even dimension, and
+ * callers should place the draws of every scattering event at a fixed
+ * dimension by setDimension, so that the pairs line up across paths no matter
+ * how many numbers earlier events consumed.
+ *
+ * - Sobol: sobol dimensions 0 and 1 with owen scrambling and index shuffling
+ *   seeded by pixel and dimension pair, as proposed in "practical hash-based
+ *   owen scrambling" by burley.
+ * - Rank1: the r2 kronecker sequence, rotated by a blue-noise dither of the
+ *   pixel and a hash of the dimension pair.
+ * - Philox: philox4x32-10 keyed by the pixel, with sample index and
+ *   dimension as counter. see "parallel random numbers: as easy as 1, 2, 3"
+ *   by salmon et al.
+ */
+class PathSampler
+{
+public:
+
+    PathSampler() noexcept;
+
+    PathSampler(SamplerType type, int x, int y, uint32_t sampleIndex) noexcept;
+
+    /**
+     * @brief continue with the given dimension
+     */
+    void setDimension(uint32_t dimension) noexcept;
+
+    float next1D() noexcept;
+
+    /**
+     * @brief skip to the next even dimension and draw a stratified pair
+     */
+    Float2 next2D() noexcept;
+
+private:
+
+    static void philox(
+        const uint32_t counter[4], uint32_t key0, uint32_t key1,
+        uint32_t result[4]) noexcept;
+
+    static uint32_t reverseBits(uint32_t x) noexcept;
+
+    static uint32_t hashCombine(uint32_t seed, uint32_t v) noexcept;
+
+    static uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) noexcept;
+
+    static uint32_t sobol(uint32_t index, int dim) noexcept;
+
+    static float toFloat(uint32_t x) noexcept;
+
+    float nextSobol() noexcept;
+
+    float nextRank1() noexcept;
+
+    float nextPhilox() noexcept;
+
+    SamplerType type_;
+    int         x_;
+    int         y_;
+    uint32_t    pixelSeed_;
+    uint32_t    pixelDither_;
+    uint32_t    sampleIndex_;
+    uint32_t    dimension_;
+
+    // philox produces 4 dimensions at once. philoxBlockIndex_ is
+    // dimension / 4 of the cached block.
+    uint32_t philoxBlock_[4];
+    uint32_t philoxBlockIndex_;
+};
+
+inline float randomFloat(PathSampler &sampler) noexcept
+{
+    return sampler.next1D();
+}
+
+inline PathSampler::PathSampler() noexcept
+    : PathSampler(SamplerType::Philox, 0, 0, 0)
+{
+
+}
+
+inline PathSampler::PathSampler(
+    SamplerType type, int x, int y, uint32_t sampleIndex) noexcept
+    : type_(type), x_(x), y_(y), sampleIndex_(sampleIndex), dimension_(0),
+      philoxBlock_{}, philoxBlockIndex_(UINT32_MAX)
+{
+    pixelSeed_ = wangHash(
+        wangHash(static_cast<uint32_t>(x)) ^ static_cast<uint32_t>(y));
+
+    // r2 dither, which has blue-noise-like spectrum over pixels
+    pixelDither_ =
+        static_cast<uint32_t>(x) * 3242174889u +
+        static_cast<uint32_t>(y) * 2447445414u;
+}
+
+inline void PathSampler::setDimension(uint32_t dimension) noexcept
+{
+    dimension_ = dimension;
+}
+
+inline float PathSampler::next1D() noexcept
+{
+    switch(type_)
+    {
+    case SamplerType::Sobol:
+        return nextSobol();
+    case SamplerType::Rank1:
+        return nextRank1();
+    default:
+        return nextPhilox();
+    }
+}
+
+inline Float2 PathSampler::next2D() noexcept
+{
+    dimension_ = (dimension_ + 1) & ~1u;
+    const float u = next1D();
+    const float v = next1D();
+    return { u, v };
+}
+
+inline void PathSampler::philox(
+    const uint32_t counter[4], uint32_t key0, uint32_t key1,
+    uint32_t result[4]) noexcept
+{
+    uint32_t c0 = counter[0], c1 = counter[1];
+    uint32_t c2 = counter[2], c3 = counter[3];
+
+    for(int round = 0; round < 10; ++round)
+    {
+        const uint64_t p0 = uint64_t(0xd2511f53u) * c0;
+        const uint64_t p1 = uint64_t(0xcd9e8d57u) * c2;
+
+        const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+        const uint32_t lo0 = static_cast<uint32_t>(p0);
+        const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+        const uint32_t lo1 = static_cast<uint32_t>(p1);
+
+        c0 = hi1 ^ c1 ^ key0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ key1;
+        c3 = lo0;
+
+        key0 += 0x9e3779b9u;
+        key1 += 0xbb67ae85u;
+    }
+
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+
+inline uint32_t PathSampler::reverseBits(uint32_t x) noexcept
+{
+    x = ((x & 0xaaaaaaaa) >> 1) | ((x & 0x55555555) << 1);
+    x = ((x & 0xcccccccc) >> 2) | ((x & 0x33333333) << 2);
+    x = ((x & 0xf0f0f0f0) >> 4) | ((x & 0x0f0f0f0f) << 4);
+    x = ((x & 0xff00ff00) >> 8) | ((x & 0x00ff00ff) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+inline uint32_t PathSampler::hashCombine(uint32_t seed, uint32_t v) noexcept
+{
+    return seed ^ (v + (seed << 6) + (seed >> 2));
+}
+
+inline uint32_t PathSampler::nestedUniformScramble(
+    uint32_t x, uint32_t seed) noexcept
+{
+    // laine-karras permutation on reversed bits
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+
+inline uint32_t PathSampler::sobol(uint32_t index, int dim) noexcept
+{
+    if(dim == 0)
+        return reverseBits(index);
+
+    uint32_t result = 0;
+    for(uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+    {
+        if(index & 1)
+            result ^= v;
+    }
+    return result;
+}
+
+inline float PathSampler::toFloat(uint32_t x) noexcept
+{
+    return (x >> 8) * (1.0f / 0x01000000);
+}
+
+inline float PathSampler::nextSobol() noexcept
+{
+    const uint32_t pair = dimension_ >> 1;
+    const int      dim  = static_cast<int>(dimension_ & 1);
+    ++dimension_;
+
+    const uint32_t pairSeed = wangHash(hashCombine(pixelSeed_, pair));
+    const uint32_t index    = nestedUniformScramble(sampleIndex_, pairSeed);
+    return toFloat(nestedUniformScramble(
+        sobol(index, dim), hashCombine(pairSeed, dim + 1)));
+}
+
+inline float PathSampler::nextPhilox() noexcept
+{
+    const uint32_t lane  = dimension_ & 3;
+    const uint32_t block = dimension_ >> 2;
+    if(block != philoxBlockIndex_)
+    {
+        const uint32_t counter[4] = { sampleIndex_, block, 0, 0 };
+        philox(
+            counter,
+            static_cast<uint32_t>(x_), static_cast<uint32_t>(y_),
+            philoxBlock_);
+        philoxBlockIndex_ = block;
+    }
+    ++dimension_;
+    return toFloat(philoxBlock_[lane]);
+}
+
+inline float PathSampler::nextRank1() noexcept
+{
+    // 2^32 / plastic number and 2^32 / plastic number ^ 2
+    constexpr uint32_t R2_ALPHA[2] = { 3242174889u, 2447445414u };
+
+    const uint32_t pair = dimension_ >> 1;
+    const int      dim  = static_cast<int>(dimension_ & 1);
+    ++dimension_;
+
+    const uint32_t rotation =
+        pixelDither_ + wangHash(hashCombine(pair, dim + 1));
+    return toFloat(sampleIndex_ * R2_ALPHA[dim] + rotation);
+}
+
+PCL_END
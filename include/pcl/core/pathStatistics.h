@@ -0,0 +1,56 @@
+#pragma once
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+enum class PathTermination : int
+{
+    Escaped        = 0, // no plane in front of the ray
+    BackLight      = 1, // hit the back light plane
+    OutOfBounds    = 2, // hit a plane outside of the paper rectangle
+    DepthExhausted = 3, // ran out of path iterations
+    Roulette       = 4, // killed by russian roulette
+    Absorbed       = 5, // bsdf sampling failed
+
+    Count          = 6
+};
+
+/**
+ * @brief statistics of traced paths
+ *
+ * a path takes one iteration per ray segment, i.e. one more than its
+ * scattering events. unlike asset/tracing.hlsl, crossing hollow planes is
+ * free, see traversePacket.
+ */
+struct PathStatistics
+{
+    uint64_t pathCount      = 0;
+    uint64_t iterationCount = 0;
+    uint64_t scatterCount   = 0;
+
+    uint64_t terminations[static_cast<int>(PathTermination::Count)] = {};
+
+    // element i is the number of paths with i scattering events
+    std::vector<uint64_t> scatterDepthHistogram;
+
+    void clear() noexcept;
+
+    void merge(const PathStatistics &rhs);
+
+    void addPath(PathTermination termination, int iterations, int scatterDepth);
+
+    uint64_t getTerminationCount(PathTermination termination) const noexcept;
+
+    double getMeanIterationCount() const noexcept;
+
+    double getMeanScatterDepth() const noexcept;
+};
+
+inline uint64_t PathStatistics::getTerminationCount(
+    PathTermination termination) const noexcept
+{
+    return terminations[static_cast<int>(termination)];
+}
+
+PCL_END
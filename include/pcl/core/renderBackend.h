@@ -0,0 +1,52 @@
+#pragma once
+
+#include <pcl/core/paperLayer.h>
+
+PCL_BEGIN
+
+/**
+ * @brief scene-facing interface shared by all tracer implementations
+ *
+ * lengths are measured in paper texels. how the rendered image is retrieved
+ * depends on the concrete backend.
+ */
+class RenderBackend : public agz::misc::uncopyable_t
+{
+public:
+
+    using Texel = PaperTexel;
+
+    virtual ~RenderBackend() = default;
+
+    virtual void setPaperSize(const Int3 &paperSize) = 0;
+
+    virtual void setOutputSize(const Int2 &newOutputSize) = 0;
+
+    virtual void setSPP(int spp) noexcept = 0;
+
+    virtual void setPaperData(int z, const Texel *data) = 0;
+
+    virtual void setBackLightRadiance(const agz::math::color3f *data) = 0;
+
+    virtual void setPaperDiffuse(int z, float reflectionRatio) = 0;
+
+    virtual void setPaperJensen(
+        int z,
+        float gf, float gb, float wf, float wb,
+        float frontEta, float backEta,
+        float frontM, float backM,
+        float d, float sigmaS, float sigmaA,
+        const Float3 &diffusionAlbedo) = 0;
+
+    virtual void setPaperDistance(float distance) noexcept = 0;
+
+    virtual void setBackLightDistance(float distance) noexcept = 0;
+
+    virtual void setEnvLight(const Float3 &envLight) noexcept = 0;
+
+    virtual void setEyeZ(float z) noexcept = 0;
+
+    virtual void render() = 0;
+};
+
+PCL_END
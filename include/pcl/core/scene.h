@@ -0,0 +1,90 @@
+#pragma once
+
+#include <pcl/core/renderBackend.h>
+
+PCL_BEGIN
+
+struct JensenParams
+{
+    float gf               = 0.335f;
+    float gb               = -0.841f;
+    float wf               = 0.997f;
+    float frontEta         = 1.29f;
+    float backEta          = 1.55f;
+    float frontM           = 0.419f;
+    float backM            = 0.892f;
+    float d                = 0.262f;
+    float sigmaS           = 81.38f;
+    float sigmaA           = 0.001f;
+    Float3 diffusionAlbedo = { 0.54f, 0.54f, 0.54f };
+};
+
+/**
+ * @brief 64-bit fnv-1a hash of all parameters
+ */
+uint64_t hashJensenParams(const JensenParams &params) noexcept;
+
+/**
+ * @brief user-facing scene parameters
+ *
+ * distances are measured in millimeters and colors are gamma-encoded, as
+ * shown in the setting panel.
+ */
+struct SceneParams
+{
+    // material of layers without their own one
+    JensenParams jensenParams;
+
+    float paperDistance     = 10;
+    float paperWidth        = 200;
+    float backLightDistance = 1;
+
+    float  lightIntensity = 1;
+    Float3 envLight       = { 0, 0, 0 };
+
+    bool  perspectiveCamera  = false;
+    float perspectiveCameraZ = 1;
+
+    float getTracerPaperDistance(int paperTexelWidth) const noexcept;
+
+    float getTracerBackLightDistance(int paperTexelWidth) const noexcept;
+
+    Float3 getLinearEnvLight() const noexcept;
+
+    float getEyeZ() const noexcept;
+};
+
+/**
+ * @brief complete description of a light box
+ *
+ * a layer with an empty image is treated as fully cut out.
+ */
+struct Scene
+{
+    Int2 paperSize;
+
+    std::vector<Image2D<uint8_t>> layers;
+    Image2D<agz::math::color3b>   light;
+
+    // per-layer materials. layers beyond the end use params.jensenParams
+    std::vector<JensenParams> layerMaterials;
+
+    SceneParams params;
+
+    const JensenParams &getLayerMaterial(int z) const noexcept;
+};
+
+void setPaperJensen(
+    RenderBackend &backend, int z, const JensenParams &params);
+
+Image2D<agz::math::color3f> computeBackLightRadiance(
+    const Image2D<agz::math::color3b> &light, float intensity);
+
+/**
+ * @brief upload everything in scene to backend
+ *
+ * throws PCLException if the size of a layer or the light is unmatched
+ */
+void uploadScene(const Scene &scene, RenderBackend &backend);
+
+PCL_END
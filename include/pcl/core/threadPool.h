@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <pcl/core/common.h>
+
+PCL_BEGIN
+
+/**
+ * @brief fixed-size worker pool executing indexed tasks with work stealing
+ *
+ * each worker owns a deque initially filled with a contiguous range of task
+ * indices. a worker pops tasks from the back of its own deque and steals from
+ * the front of others when it runs out of work.
+ */
+class ThreadPool : public agz::misc::uncopyable_t
+{
+public:
+
+    using Func = std::function<void(int threadIndex, int taskIndex)>;
+
+    /**
+     * @param threadCount number of workers (including the calling thread).
+     *  non-positive values are added to the hardware concurrency.
+     */
+    explicit ThreadPool(int threadCount = 0);
+
+    ~ThreadPool();
+
+    int getThreadCount() const noexcept;
+
+    /**
+     * @brief execute func for each task index in [0, taskCount)
+     *
+     * the calling thread works as worker 0 and returns after all tasks have
+     * been finished.
+     */
+    void parallelFor(int taskCount, const Func &func);
+
+private:
+
+    struct TaskQueue
+    {
+        std::mutex      mutex;
+        std::deque<int> tasks;
+    };
+
+    bool popTask(int threadIndex, int *task);
+
+    void runTasks(int threadIndex);
+
+    void workerMain(int threadIndex);
+
+    int threadCount_;
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread>                workers_;
+
+    std::mutex              mutex_;
+    std::condition_variable startCond_;
+    std::condition_variable doneCond_;
+
+    const Func *func_;
+    uint64_t    generation_;
+    int         pendingTasks_;
+    int         activeWorkers_;
+    bool        stop_;
+};
+
+PCL_END
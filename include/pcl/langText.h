@@ -47,12 +47,18 @@
 #define PCL_LANG_SIGMA_S "sigma_s"
 #define PCL_LANG_SIGMA_A "sigma_a"
 #define PCL_LANG_DIF_ALBEDO "diffusion albedo"
+#define PCL_LANG_APPLY_TO_ALL_LAYERS "apply to all layers"
 
 #define PCL_LANG_SPP "sampling"
 
 #define PCL_LANG_GPU_PERFORMANCE "GPU performance"
 #define PCL_LANG_RENDER_QUALITY  "render quality"
 
+#define PCL_LANG_NOISE_THRESHOLD      "noise threshold"
+#define PCL_LANG_NOISE_THRESHOLD_TIPS "pixels stop being sampled when their relative noise is below this value. 0 disables adaptive sampling"
+#define PCL_LANG_RENDER_PROGRESS      "frames: %d, unconverged pixels: %.1f%%"
+#define PCL_LANG_REMAINING_TIME       "remaining time: %.0fs"
+
 #else
 
 #define PCL_LANG_FILE_NOT_SPECIFIED u8"警告：未指定文件名"
@@ -100,10 +106,16 @@
 #define PCL_LANG_SIGMA_S         u8"内部散射率"
 #define PCL_LANG_SIGMA_A         u8"内部吸收率"
 #define PCL_LANG_DIF_ALBEDO      u8"Diffusion Albedo"
+#define PCL_LANG_APPLY_TO_ALL_LAYERS u8"应用到所有图层"
 
 #define PCL_LANG_SPP u8"采样设置"
 
 #define PCL_LANG_GPU_PERFORMANCE u8"GPU性能"
 #define PCL_LANG_RENDER_QUALITY  u8"绘制质量"
 
+#define PCL_LANG_NOISE_THRESHOLD      u8"噪声阈值"
+#define PCL_LANG_NOISE_THRESHOLD_TIPS u8"像素的相对噪声低于该值时停止采样，0表示禁用自适应采样"
+#define PCL_LANG_RENDER_PROGRESS      u8"帧数：%d，未收敛像素：%.1f%%"
+#define PCL_LANG_REMAINING_TIME       u8"剩余时间：%.0f秒"
+
 #endif
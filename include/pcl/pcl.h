@@ -1,7 +1,11 @@
 #pragma once
 
+#include <chrono>
+
 #include <agz-utils/graphics_api.h>
 
+#include <pcl/core/layerMaterials.h>
+#include <pcl/core/scene.h>
 #include <pcl/renderer/accumulator.h>
 #include <pcl/renderer/toneMapper.h>
 #include <pcl/renderer/tracer.h>
@@ -38,33 +42,38 @@ private:
 
         Status status   = Status::Nil;
         LayerID layerID = 0;
-    };
 
-    struct JensenParams
-    {
-        float gf               = 0.335f;
-        float gb               = -0.841f;
-        float wf               = 0.997f;
-        float frontEta         = 1.29f;
-        float backEta          = 1.55f;
-        float frontM           = 0.419f;
-        float backM            = 0.892f;
-        float d                = 0.262f;
-        float sigmaS           = 81.38f;
-        float sigmaA           = 0.001f;
-        Float3 diffusionAlbedo = { 0.54f, 0.54f, 0.54f };
+        JensenParams material;
     };
 
     void showStatusText(PaperRecord::Status status) const;
 
     void updatePaperBinary(size_t paperIndex);
 
+    /**
+     * @brief upload materials of layers changed since the last call, and
+     *  restart accumulation if there is any
+     */
     void updateMaterial();
 
+    /**
+     * @brief resize the tracer to the current layers. materials of all
+     *  layers are uploaded by the next updateMaterial
+     */
+    void resizeTracerPapers();
+
     void displaySettingPanel();
 
     void displayRenderPanel();
 
+    /**
+     * @brief discard accumulated frames after a scene change and start the
+     *  preview ladder
+     */
+    void restartAccumulation();
+
+    void updateAdaptiveSampling();
+
     void handle(const LayerModification &event) override;
 
     void handle(const LightModification &event) override;
@@ -85,31 +94,34 @@ private:
 
     Int2 paperSize_;
 
-    JensenParams jensenParams_;
-
-    float paperDistance_;
-    float paperWidth_;
-    float backLightDistance_;
+    SceneParams sceneParams_;
 
     int spp_;
     int maxAccuFrames_;
 
-    bool perspectiveCamera_;
-    float perspectiveCameraZ_;
-    float exposure_;
+    float errorThreshold_;
+
+    // moving average of the time per rendered frame, for estimating the
+    // remaining time
+    float frameSeconds_;
+    std::chrono::steady_clock::time_point lastFrameTime_;
+
+    // time of the last scene change, which decides the preview resolution
+    std::chrono::steady_clock::time_point lastEditTime_;
+    bool isPreviewing_;
 
-    Float3 envLight_;
+    float exposure_;
 
     PaperRecord::Status lightStatus_;
     std::string lightFilename_;
     LayerID lightLayer_;
 
-    float lightIntensity_;
-
     size_t selectedPaperIdx_;
     std::vector<PaperRecord> papers_;
     std::map<LayerID, size_t> layer2PaperIdx_;
 
+    LayerMaterials layerMaterials_;
+
     std::unique_ptr<LayerMonitor> monitor_;
 
     std::unique_ptr<Tracer>      tracer_;
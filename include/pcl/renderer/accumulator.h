@@ -4,6 +4,15 @@
 
 PCL_BEGIN
 
+/**
+ * @brief running mean of traced frames with per-pixel convergence tracking
+ *
+ * frames are added in place to a kahan-compensated sum, and the mean is only
+ * resolved when getAccumulatedOutput is called. see CpuAccumulator for the
+ * convergence criterion. converged pixels are marked in getConvergedMask,
+ * which is read by the tracer to skip them. statistics are read back from
+ * the gpu with a latency of a few frames.
+ */
 class Accumulator : public agz::misc::uncopyable_t
 {
 public:
@@ -12,40 +21,79 @@ public:
 
     void setSize(int width, int height);
 
+    /**
+     * @brief errorThreshold <= 0 disables adaptive sampling. maxFrameCount
+     *  only caps the estimation of getRemainingPixelFrames.
+     */
+    void setAdaptiveSampling(
+        float errorThreshold, int minFrameCount, int maxFrameCount) noexcept;
+
     void clearHistory();
 
     void addNewFrame(ComPtr<ID3D11ShaderResourceView> srv);
 
-    ComPtr<ID3D11ShaderResourceView> getAccumulatedOutput() const;
+    /**
+     * @brief mean of all added frames. resolved from the sum on the first
+     *  call after a change
+     */
+    ComPtr<ID3D11ShaderResourceView> getAccumulatedOutput();
 
     int getAccumulatedFrameCount() const noexcept;
 
+    ComPtr<ID3D11ShaderResourceView> getConvergedMask() const;
+
+    int getPixelCount() const noexcept;
+
+    int getUnconvergedPixelCount() const noexcept;
+
+    /**
+     * @brief estimated number of pixel frames until all pixels converge
+     */
+    double getRemainingPixelFrames() const noexcept;
+
+    bool isConverged() const noexcept;
+
 private:
 
     void initShader();
 
-    void initPingPongTextures();
+    void initAccumulationTextures();
+
+    void initConvergedMask();
+
+    void initStatisticsBuffers();
 
     void initPerFrameConsts();
 
-    struct PerFrame
+    void readStatistics();
+
+    struct ConvergePerFrame
     {
-        float historyWeight;
-        float newFrameWeight;
-        float pad0[2];
+        float errorThreshold;
+        float minFrameCount;
+        float maxFrameCount;
+        float pad0;
     };
 
     UINT width_;
     UINT height_;
 
+    float errorThreshold_;
+    int   minFrameCount_;
+    int   maxFrameCount_;
+
     d3d11::Shader<d3d11::CS>          shader_;
     d3d11::ResourceManager<d3d11::CS> rscMgr_;
 
-    d3d11::ShaderResourceViewSlot<d3d11::CS>  *historySlot_;
-    d3d11::ShaderResourceViewSlot<d3d11::CS>  *newFrameSlot_;
-    d3d11::UnorderedAccessViewSlot<d3d11::CS> *outputSlot_;
+    d3d11::ShaderResourceViewSlot<d3d11::CS> *newFrameSlot_;
+
+    d3d11::Shader<d3d11::CS>          convergeShader_;
+    d3d11::ResourceManager<d3d11::CS> convergeRscMgr_;
 
-    d3d11::ConstantBuffer<PerFrame> perFrame_;
+    d3d11::ConstantBuffer<ConvergePerFrame> convergePerFrame_;
+
+    d3d11::Shader<d3d11::CS>          resolveShader_;
+    d3d11::ResourceManager<d3d11::CS> resolveRscMgr_;
 
     struct Buffer
     {
@@ -53,8 +101,26 @@ private:
         ComPtr<ID3D11UnorderedAccessView> uav;
     };
 
-    Buffer accumulated_;
-    Buffer nextTarget_;
+    Buffer sum_;
+    Buffer moments_;
+
+    // resolved mean, valid when isMeanResolved_ is true
+    Buffer mean_;
+    bool   isMeanResolved_;
+
+    Buffer converged_;
+
+    ComPtr<ID3D11Buffer>              statisticsBuf_;
+    ComPtr<ID3D11UnorderedAccessView> statisticsUAV_;
+    ComPtr<ID3D11Buffer>              statisticsStagingBuf_;
+
+    // a copy to the staging buffer is in flight. it is discarded when the
+    // history has been cleared after the copy.
+    bool statisticsPending_;
+    bool discardPendingStatistics_;
+
+    int    unconvergedPixelCount_;
+    double remainingPixelFrames_;
 
     int accumulatedCount_;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <pcl/core/jensenRhoDt.h>
 #include <pcl/common.h>
 
 PCL_BEGIN
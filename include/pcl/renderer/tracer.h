@@ -1,39 +1,31 @@
 #pragma once
 
+#include <pcl/core/renderBackend.h>
 #include <pcl/common.h>
 
 PCL_BEGIN
 
-class Tracer : public agz::misc::uncopyable_t
+class Tracer : public RenderBackend
 {
 public:
 
-    struct Texel
-    {
-        uint8_t r;
-        uint8_t g;
-        uint8_t b;
-
-        uint8_t binary;
-    };
-
     Tracer(
         const Int2 &outputSize,
         const Int3 &paperSize,
         float       paperDistance,
         int         spp);
 
-    void setPaperSize(const Int3 &paperSize);
+    void setPaperSize(const Int3 &paperSize) override;
 
-    void setOutputSize(const Int2 &newOutputSize);
+    void setOutputSize(const Int2 &newOutputSize) override;
 
-    void setSPP(int spp) noexcept;
+    void setSPP(int spp) noexcept override;
 
-    void setPaperData(int z, const Texel *data);
+    void setPaperData(int z, const Texel *data) override;
 
-    void setBackLightRadiance(const agz::math::color3f *data);
+    void setBackLightRadiance(const agz::math::color3f *data) override;
 
-    void setPaperDiffuse(int z, float reflectionRatio);
+    void setPaperDiffuse(int z, float reflectionRatio) override;
 
     void setPaperJensen(
         int z,
@@ -41,20 +33,41 @@ public:
         float frontEta, float backEta,
         float frontM, float backM,
         float d, float sigmaS, float sigmaA,
-        const Float3 &diffusionAlbedo);
+        const Float3 &diffusionAlbedo) override;
+
+    void setPaperDistance(float distance) noexcept override;
+
+    void setBackLightDistance(float distance) noexcept override;
 
-    void setPaperDistance(float distance) noexcept;
+    void setEnvLight(const Float3 &envLight) noexcept override;
 
-    void setBackLightDistance(float distance) noexcept;
+    void setEyeZ(float z) noexcept override;
 
-    void setEnvLight(const Float3 &envLight) noexcept;
+    void render() override;
 
-    void setEyeZ(float z) noexcept;
+    /**
+     * @brief trace only one pixel of every scale x scale block and copy its
+     *  result to the whole block. 1 traces every pixel.
+     */
+    void setPreviewScale(int scale) noexcept;
 
-    void render() const;
+    /**
+     * @brief max number of scattering events of a path. plane crossings are
+     *  not limited by this, so that light still passes through deep stacks.
+     */
+    void setMaxScatterDepth(int maxScatterDepth) noexcept;
+
+    // a path never has more scattering events than iterations
+    static constexpr int DEFAULT_MAX_SCATTER_DEPTH = 20;
 
     ComPtr<ID3D11ShaderResourceView> getOutput() const;
 
+    /**
+     * @brief pixels with non-zero values are not traced. output of these
+     *  pixels is left unchanged. see Accumulator::getConvergedMask.
+     */
+    void setConvergedMask(ComPtr<ID3D11ShaderResourceView> mask);
+
 private:
 
     void initShader();
@@ -87,6 +100,9 @@ private:
         float    backLightDistance;
         Float3   envLight;
         float    eyeZ;
+        uint32_t previewScale;
+        uint32_t maxScatterDepth;
+        float    pad0[2];
     };
 
     struct PaperMaterial
@@ -102,11 +118,20 @@ private:
         float m16, m17, m18, m19;
     };
 
+    void setPaperMaterial(int z, const PaperMaterial &material);
+
+    /**
+     * @brief upload all materials changed since the last render at once
+     */
+    void flushPaperMaterials();
+
     Int2  outputSize_;
     Int3  paperSize_;
     float paperDistance_;
     float backLightDistance_;
     int   spp_;
+    int   previewScale_;
+    int   maxScatterDepth_;
 
     Float3 envLight_;
     float eyeZ_;
@@ -122,6 +147,12 @@ private:
     ComPtr<ID3D11Buffer>             paperMaterialsBuf_;
     ComPtr<ID3D11ShaderResourceView> paperMaterialsSRV_;
 
+    // cpu copy of the material buffer. layers in [dirtyMaterialBegin_,
+    // dirtyMaterialEnd_) are uploaded by the next render
+    std::vector<PaperMaterial> paperMaterials_;
+    int dirtyMaterialBegin_;
+    int dirtyMaterialEnd_;
+
     ComPtr<ID3D11Texture2D>          papersTex_;
     ComPtr<ID3D11ShaderResourceView> papersSRV_;
 
@@ -132,6 +163,8 @@ private:
     ComPtr<ID3D11UnorderedAccessView> outputUAV_;
     ComPtr<ID3D11ShaderResourceView>  outputSRV_;
 
+    ComPtr<ID3D11ShaderResourceView> convergedMask_;
+
     ComPtr<ID3D11ShaderResourceView> jensenRhoDt_;
     ComPtr<ID3D11SamplerState> jensenLinearSampler_;
 };
@@ -0,0 +1,579 @@
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+#include <agz-utils/image.h>
+
+#include <pcl/core/cpuAccumulator.h>
+#include <pcl/core/cpuAutoExposure.h>
+#include <pcl/core/cpuDenoiser.h>
+#include <pcl/core/cpuToneMapper.h>
+#include <pcl/core/cpuTracer.h>
+#include <pcl/core/scene.h>
+
+namespace
+{
+
+    const char *USAGE = R"___(usage: pcl-batch [options]
+
+required:
+    --layers f0 f1 ...      paper layer images, from front to back
+    --output filename       output png file
+
+scene:
+    --light filename        back light image
+    --light-intensity v     default: 1
+    --light-distance mm     default: 1
+    --paper-width mm        default: 200
+    --paper-distance mm     default: 10
+    --env-light r g b       gamma-encoded, default: 0 0 0
+    --perspective z         use perspective camera with given distance (0-4.9)
+    --exposure v            default: 1. multiplies the automatic exposure
+                            when --auto-exposure is given
+    --auto-exposure         expose the accumulated luminance histogram to
+                            middle grey
+
+material:
+    --front-g v --back-g v --front-g-weight v
+    --front-ior v --back-ior v --front-rough v --back-rough v
+    --thickness v --sigma-s v --sigma-a v --albedo r g b
+
+rendering:
+    --output-width n        default: width of layer images
+    --spp n                 samples per pixel per frame, default: 1
+    --samples n             stop after n samples per pixel
+    --time seconds          stop after given wall-clock time
+    --error v               stop sampling pixels whose relative standard
+                            error is below v, and stop rendering when all
+                            pixels are converged. default: 0 (disabled)
+    --min-samples n         samples per pixel before the error is tested,
+                            default: 16
+    --threads n             default: all cores
+    --max-depth n           max ray segments per path, default: 20
+    --rr-depth n            scattering events before russian roulette,
+                            default: 3
+    --sampler name          philox, sobol or rank1, default: sobol
+    --jensen-table          evaluate the paper bsdf by lookup tables
+    --rho-dt-size n         resolution of the rho_dt table, default: 64.
+                            see pcl-rho-dt
+    --first-sample n        index of the first sample, default: 0. renders
+                            of disjoint sample ranges can be averaged.
+    --denoise               filter the output guided by paper layers
+    --checkpoint seconds    save the undenoised image to the output file
+                            periodically while rendering
+
+    rendering stops at whichever budget is reached first. when neither
+    --samples nor --time is given, at most 1024 samples per pixel are
+    rendered.
+)___";
+
+    struct BatchParams
+    {
+        std::vector<std::string> layerFilenames;
+        std::string lightFilename;
+        std::string outputFilename;
+
+        pcl::SceneParams scene;
+        float exposure     = 1;
+        bool  autoExposure = false;
+
+        int    outputWidth = 0;
+        int    spp         = 1;
+        int    threadCount = 0;
+        int    maxSamples  = 0;
+        double maxSeconds  = 0;
+
+        float errorThreshold = 0;
+        int   minSamples     = 16;
+
+        bool   denoise           = false;
+        double checkpointSeconds = 0;
+
+        int maxDepth      = pcl::CpuTracer::DEFAULT_MAX_DEPTH;
+        int rouletteDepth = pcl::CpuTracer::DEFAULT_ROULETTE_DEPTH;
+
+        pcl::SamplerType samplerType = pcl::SamplerType::Sobol;
+        int firstSample = 0;
+
+        bool jensenTable = false;
+        int  rhoDtSize   = pcl::JENSEN_RHO_DT_DEFAULT_SIZE;
+    };
+
+    class ArgReader
+    {
+    public:
+
+        ArgReader(int argc, char *argv[])
+            : args_(argv + 1, argv + argc), index_(0)
+        {
+
+        }
+
+        bool hasNext() const noexcept
+        {
+            return index_ < args_.size();
+        }
+
+        bool isNextOption() const noexcept
+        {
+            return hasNext() && args_[index_].rfind("--", 0) == 0;
+        }
+
+        const std::string &next(const std::string &opt)
+        {
+            if(!hasNext())
+                throw pcl::PCLException("missing value of " + opt);
+            return args_[index_++];
+        }
+
+        float nextFloat(const std::string &opt)
+        {
+            const std::string &s = next(opt);
+            try
+            {
+                return std::stof(s);
+            }
+            catch(...)
+            {
+                throw pcl::PCLException(
+                    "invalid value of " + opt + ": " + s);
+            }
+        }
+
+        int nextInt(const std::string &opt)
+        {
+            const std::string &s = next(opt);
+            try
+            {
+                return std::stoi(s);
+            }
+            catch(...)
+            {
+                throw pcl::PCLException(
+                    "invalid value of " + opt + ": " + s);
+            }
+        }
+
+        pcl::Float3 nextFloat3(const std::string &opt)
+        {
+            const float x = nextFloat(opt);
+            const float y = nextFloat(opt);
+            const float z = nextFloat(opt);
+            return { x, y, z };
+        }
+
+    private:
+
+        std::vector<std::string> args_;
+        size_t index_;
+    };
+
+    BatchParams parseArgs(int argc, char *argv[])
+    {
+        BatchParams params;
+        auto &jensen = params.scene.jensenParams;
+
+        ArgReader reader(argc, argv);
+        while(reader.hasNext())
+        {
+            const std::string opt = reader.next("");
+
+            if(opt == "--layers")
+            {
+                while(reader.hasNext() && !reader.isNextOption())
+                    params.layerFilenames.push_back(reader.next(opt));
+            }
+            else if(opt == "--output")
+                params.outputFilename = reader.next(opt);
+            else if(opt == "--light")
+                params.lightFilename = reader.next(opt);
+            else if(opt == "--light-intensity")
+                params.scene.lightIntensity = reader.nextFloat(opt);
+            else if(opt == "--light-distance")
+                params.scene.backLightDistance = reader.nextFloat(opt);
+            else if(opt == "--paper-width")
+                params.scene.paperWidth = (std::max)(
+                    reader.nextFloat(opt), 10.0f);
+            else if(opt == "--paper-distance")
+                params.scene.paperDistance = reader.nextFloat(opt);
+            else if(opt == "--env-light")
+                params.scene.envLight = reader.nextFloat3(opt);
+            else if(opt == "--perspective")
+            {
+                params.scene.perspectiveCamera  = true;
+                params.scene.perspectiveCameraZ = agz::math::clamp(
+                    reader.nextFloat(opt), 0.0f, 4.9f);
+            }
+            else if(opt == "--exposure")
+                params.exposure = reader.nextFloat(opt);
+            else if(opt == "--auto-exposure")
+                params.autoExposure = true;
+            else if(opt == "--front-g")
+                jensen.gf = reader.nextFloat(opt);
+            else if(opt == "--back-g")
+                jensen.gb = reader.nextFloat(opt);
+            else if(opt == "--front-g-weight")
+                jensen.wf = reader.nextFloat(opt);
+            else if(opt == "--front-ior")
+                jensen.frontEta = reader.nextFloat(opt);
+            else if(opt == "--back-ior")
+                jensen.backEta = reader.nextFloat(opt);
+            else if(opt == "--front-rough")
+                jensen.frontM = reader.nextFloat(opt);
+            else if(opt == "--back-rough")
+                jensen.backM = reader.nextFloat(opt);
+            else if(opt == "--thickness")
+                jensen.d = reader.nextFloat(opt);
+            else if(opt == "--sigma-s")
+                jensen.sigmaS = reader.nextFloat(opt);
+            else if(opt == "--sigma-a")
+                jensen.sigmaA = reader.nextFloat(opt);
+            else if(opt == "--albedo")
+                jensen.diffusionAlbedo = reader.nextFloat3(opt);
+            else if(opt == "--output-width")
+                params.outputWidth = reader.nextInt(opt);
+            else if(opt == "--spp")
+                params.spp = (std::max)(reader.nextInt(opt), 1);
+            else if(opt == "--samples")
+                params.maxSamples = reader.nextInt(opt);
+            else if(opt == "--time")
+                params.maxSeconds = reader.nextFloat(opt);
+            else if(opt == "--error")
+                params.errorThreshold = reader.nextFloat(opt);
+            else if(opt == "--min-samples")
+                params.minSamples = (std::max)(reader.nextInt(opt), 1);
+            else if(opt == "--denoise")
+                params.denoise = true;
+            else if(opt == "--checkpoint")
+                params.checkpointSeconds = reader.nextFloat(opt);
+            else if(opt == "--threads")
+                params.threadCount = reader.nextInt(opt);
+            else if(opt == "--max-depth")
+                params.maxDepth = (std::max)(reader.nextInt(opt), 1);
+            else if(opt == "--rr-depth")
+                params.rouletteDepth = (std::max)(reader.nextInt(opt), 0);
+            else if(opt == "--sampler")
+            {
+                const std::string &name = reader.next(opt);
+                if(name == "philox")
+                    params.samplerType = pcl::SamplerType::Philox;
+                else if(name == "sobol")
+                    params.samplerType = pcl::SamplerType::Sobol;
+                else if(name == "rank1")
+                    params.samplerType = pcl::SamplerType::Rank1;
+                else
+                {
+                    throw pcl::PCLException(
+                        "invalid value of " + opt + ": " + name);
+                }
+            }
+            else if(opt == "--jensen-table")
+                params.jensenTable = true;
+            else if(opt == "--rho-dt-size")
+                params.rhoDtSize = (std::max)(reader.nextInt(opt), 2);
+            else if(opt == "--first-sample")
+                params.firstSample = (std::max)(reader.nextInt(opt), 0);
+            else
+                throw pcl::PCLException("unknown option: " + opt);
+        }
+
+        if(params.layerFilenames.empty())
+            throw pcl::PCLException("no paper layer is specified");
+        if(params.outputFilename.empty())
+            throw pcl::PCLException("output filename is not specified");
+
+        if(params.maxSamples <= 0 && params.maxSeconds <= 0)
+            params.maxSamples = 1024;
+
+        return params;
+    }
+
+    pcl::Image2D<agz::math::color3b> loadImage(const std::string &filename)
+    {
+        try
+        {
+            return agz::img::load_rgb_from_file(filename);
+        }
+        catch(...)
+        {
+            throw pcl::PCLException("failed to load image file: " + filename);
+        }
+    }
+
+    // texels packed by CpuToneMapper::mapRGBA8, r in the lowest byte
+    void saveRGBA8(
+        const std::string &filename, const pcl::Image2D<uint32_t> &img)
+    {
+        pcl::Image2D<agz::math::color3b> rgb(img.height(), img.width());
+        for(int y = 0; y < img.height(); ++y)
+        {
+            for(int x = 0; x < img.width(); ++x)
+            {
+                const uint32_t texel = img(y, x);
+                rgb(y, x) = agz::math::color3b(
+                    static_cast<uint8_t>(texel),
+                    static_cast<uint8_t>(texel >> 8),
+                    static_cast<uint8_t>(texel >> 16));
+            }
+        }
+        agz::img::save_rgb_to_png_file(filename, rgb);
+    }
+
+    pcl::Scene loadScene(const BatchParams &params)
+    {
+        pcl::Scene scene;
+        scene.params = params.scene;
+
+        for(auto &filename : params.layerFilenames)
+            scene.layers.push_back(pcl::rgbToLayerBinary(loadImage(filename)));
+
+        if(!params.lightFilename.empty())
+            scene.light = loadImage(params.lightFilename);
+
+        scene.paperSize = scene.layers.front().size();
+        return scene;
+    }
+
+    pcl::Int2 computeOutputSize(
+        const BatchParams &params, const pcl::Int2 &paperSize)
+    {
+        if(params.outputWidth <= 0)
+            return paperSize;
+
+        return {
+            params.outputWidth,
+            (std::max)(1, params.outputWidth * paperSize.y / paperSize.x)
+        };
+    }
+
+    void printPathStatistics(const pcl::PathStatistics &stats)
+    {
+        if(!stats.pathCount)
+            return;
+
+        auto percent = [&](uint64_t count)
+        {
+            return 100.0 * count / stats.pathCount;
+        };
+
+        std::cout << "path iterations: " << stats.getMeanIterationCount()
+                  << " avg, scattering events: "
+                  << stats.getMeanScatterDepth() << " avg" << std::endl;
+
+        std::cout << "terminated by roulette: "
+                  << percent(stats.getTerminationCount(
+                        pcl::PathTermination::Roulette))
+                  << "%, depth limit: "
+                  << percent(stats.getTerminationCount(
+                        pcl::PathTermination::DepthExhausted))
+                  << "%" << std::endl;
+
+        std::cout << "scattering events per path:";
+        for(size_t i = 0; i < stats.scatterDepthHistogram.size(); ++i)
+        {
+            std::cout << " " << i << ":"
+                      << percent(stats.scatterDepthHistogram[i]) << "%";
+        }
+        std::cout << std::endl;
+    }
+
+    void printProgress(
+        int sampleCount, const pcl::CpuAccumulator &accumulator,
+        int totalPixelCount, double etaSeconds)
+    {
+        std::cout << "\r" << sampleCount << " spp, "
+                  << 100.0 * accumulator.getActivePixelCount() / totalPixelCount
+                  << "% pixels active, eta " << static_cast<int>(etaSeconds)
+                  << "s        " << std::flush;
+    }
+
+    void run(const BatchParams &params)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const pcl::Scene scene = loadScene(params);
+        const pcl::Int2 outputSize = computeOutputSize(params, scene.paperSize);
+
+        pcl::CpuTracer tracer(
+            outputSize,
+            { scene.paperSize.x, scene.paperSize.y,
+              static_cast<int>(scene.layers.size()) },
+            scene.params.getTracerPaperDistance(scene.paperSize.x),
+            params.spp, params.threadCount);
+        if(params.rhoDtSize != pcl::JENSEN_RHO_DT_DEFAULT_SIZE)
+            tracer.setJensenRhoDt(pcl::getJensenRhoDt(params.rhoDtSize));
+        tracer.setJensenTableEnabled(params.jensenTable);
+        pcl::uploadScene(scene, tracer);
+        tracer.setMaxDepth(params.maxDepth);
+        tracer.setRouletteDepth(params.rouletteDepth);
+        tracer.setSamplerType(params.samplerType);
+        tracer.setSampleIndex(static_cast<uint32_t>(params.firstSample));
+
+        pcl::CpuAccumulator accumulator(outputSize.x, outputSize.y);
+        if(params.errorThreshold > 0)
+        {
+            accumulator.setAdaptiveSampling(
+                params.errorThreshold,
+                (params.minSamples + params.spp - 1) / params.spp);
+            tracer.setPixelMask(accumulator.getActiveMask());
+        }
+
+        pcl::CpuToneMapper toneMapper;
+        toneMapper.setExposure(params.exposure);
+
+        std::unique_ptr<pcl::CpuAutoExposure> autoExposure;
+        if(params.autoExposure)
+        {
+            autoExposure = std::make_unique<pcl::CpuAutoExposure>(
+                tracer.getThreadPool());
+        }
+
+        // checkpoints are tone mapped by the tracer while tiles are in cache
+        pcl::Image2D<uint32_t> checkpoint;
+        if(params.checkpointSeconds > 0)
+            checkpoint = pcl::Image2D<uint32_t>(outputSize.y, outputSize.x);
+
+        const int totalPixelCount = outputSize.x * outputSize.y;
+        const int maxFrameCount   = params.maxSamples > 0 ?
+            (params.maxSamples + params.spp - 1) / params.spp :
+            (std::numeric_limits<int>::max)();
+
+        const auto start = Clock::now();
+        auto elapsedSeconds = [&]
+        {
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        // eta is derived from the throughput in pixel frames, since the cost
+        // of a frame decreases as pixels converge
+        double pixelFrameCount    = 0;
+        double lastProgressTime   = 0;
+        double lastCheckpointTime = 0;
+        double lastFrameTime      = 0;
+
+        int sampleCount = 0;
+        for(;;)
+        {
+            pixelFrameCount += accumulator.getActivePixelCount();
+
+            const bool isCheckpoint =
+                params.checkpointSeconds > 0 &&
+                elapsedSeconds() - lastCheckpointTime >=
+                    params.checkpointSeconds;
+
+            // the exposure of checkpoints follows the histogram smoothly
+
+            if(autoExposure && params.checkpointSeconds > 0)
+            {
+                const double now = elapsedSeconds();
+                if(accumulator.getAccumulatedFrameCount() > 0)
+                {
+                    toneMapper.setExposure(
+                        params.exposure * autoExposure->update(
+                            accumulator,
+                            static_cast<float>(now - lastFrameTime)));
+                }
+                lastFrameTime = now;
+            }
+
+            if(isCheckpoint)
+            {
+                tracer.renderAccumulated(accumulator, &toneMapper, &checkpoint);
+                saveRGBA8(params.outputFilename, checkpoint);
+                lastCheckpointTime = elapsedSeconds();
+            }
+            else
+                tracer.renderAccumulated(accumulator);
+            sampleCount += params.spp;
+
+            if(params.maxSamples > 0 && sampleCount >= params.maxSamples)
+                break;
+            if(params.maxSeconds > 0 && elapsedSeconds() >= params.maxSeconds)
+                break;
+            if(accumulator.isConverged())
+                break;
+
+            const double elapsed = elapsedSeconds();
+            if(elapsed - lastProgressTime >= 1)
+            {
+                const double remaining =
+                    accumulator.estimateRemainingPixelFrames(maxFrameCount);
+                double eta = remaining * elapsed / pixelFrameCount;
+                if(params.maxSeconds > 0)
+                    eta = (std::min)(eta, params.maxSeconds - elapsed);
+
+                printProgress(sampleCount, accumulator, totalPixelCount, eta);
+                lastProgressTime = elapsed;
+            }
+        }
+
+        std::cout << "\rrendered " << sampleCount << " spp in "
+                  << elapsedSeconds() << "s";
+        if(params.errorThreshold > 0)
+        {
+            std::cout << ", " << 100.0 * accumulator.getActivePixelCount() /
+                                 totalPixelCount
+                      << "% pixels unconverged";
+        }
+        std::cout << std::endl;
+        printPathStatistics(tracer.getPathStatistics());
+
+        // the output is exposed to the final histogram without smoothing
+
+        if(autoExposure)
+        {
+            const float exposure = params.exposure *
+                autoExposure->computeTargetExposure(accumulator);
+            toneMapper.setExposure(exposure);
+            std::cout << "exposure: " << exposure << std::endl;
+        }
+
+        if(params.denoise)
+        {
+            pcl::CpuDenoiser denoiser(tracer.getThreadPool());
+            const auto &denoised = denoiser.denoise(
+                accumulator.getAccumulatedOutput(),
+                accumulator.computeVariance(), tracer.getFeatures());
+
+            agz::img::save_rgb_to_png_file(
+                params.outputFilename, toneMapper.render(denoised));
+        }
+        else
+        {
+            // tone mapped row by row, so that the mean is never resolved
+
+            pcl::Image2D<uint32_t> output(outputSize.y, outputSize.x);
+            std::vector<pcl::Float4> means(outputSize.x);
+            for(int y = 0; y < outputSize.y; ++y)
+            {
+                const int rowBeg = y * outputSize.x;
+                for(int x = 0; x < outputSize.x; ++x)
+                    means[x] = accumulator.getPixelMean(rowBeg + x);
+
+                toneMapper.mapRGBA8(
+                    means.data(), output.raw_data() + rowBeg, outputSize.x);
+            }
+            saveRGBA8(params.outputFilename, output);
+        }
+    }
+
+} // namespace anonymous
+
+int main(int argc, char *argv[])
+{
+    if(argc <= 1)
+    {
+        std::cout << USAGE;
+        return 0;
+    }
+
+    try
+    {
+        run(parseArgs(argc, argv));
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+}
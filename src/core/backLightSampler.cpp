@@ -0,0 +1,85 @@
+#include <pcl/core/backLightSampler.h>
+
+PCL_BEGIN
+
+BackLightSampler::BackLightSampler() noexcept
+    : width_(0), height_(0)
+{
+
+}
+
+void BackLightSampler::build(int width, int height, const Float3 *radiance)
+{
+    width_  = width;
+    height_ = height;
+
+    texelPdf_.clear();
+    aliasProb_.clear();
+    alias_.clear();
+
+    const size_t count = size_t(width) * height;
+
+    std::vector<double> weights(count);
+    double sum = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        weights[i] = (std::max)(getLuminance(radiance[i]), 0.0f);
+        sum += weights[i];
+    }
+
+    if(sum <= 0)
+        return;
+
+    texelPdf_.resize(count);
+    aliasProb_.resize(count);
+    alias_.resize(count);
+
+    // vose's alias method. scaled weights have mean 1
+
+    std::vector<double>   scaled(count);
+    std::vector<uint32_t> small, large;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        texelPdf_[i] = static_cast<float>(weights[i] / sum);
+        scaled[i]    = weights[i] * count / sum;
+
+        if(scaled[i] < 1)
+            small.push_back(static_cast<uint32_t>(i));
+        else
+            large.push_back(static_cast<uint32_t>(i));
+    }
+
+    while(!small.empty() && !large.empty())
+    {
+        const uint32_t s = small.back();
+        const uint32_t l = large.back();
+        small.pop_back();
+
+        aliasProb_[s] = static_cast<float>(scaled[s]);
+        alias_[s]     = l;
+
+        scaled[l] -= 1 - scaled[s];
+        if(scaled[l] < 1)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // remaining slots are full up to rounding errors
+
+    for(uint32_t i : large)
+    {
+        aliasProb_[i] = 1;
+        alias_[i]     = i;
+    }
+
+    for(uint32_t i : small)
+    {
+        aliasProb_[i] = 1;
+        alias_[i]     = i;
+    }
+}
+
+PCL_END
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pcl/core/cpuAccumulator.h>
+
+PCL_BEGIN
+
+namespace
+{
+
+    // keeps the relative error of almost black pixels bounded
+    constexpr float ERROR_LUMINANCE_BIAS = 0.01f;
+
+    constexpr int ERROR_NEIGHBOR_RADIUS = 2;
+
+    float luminance(const Float4 &c) noexcept
+    {
+        return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+    }
+
+    double luminance(const double *c) noexcept
+    {
+        return 0.2126 * c[0] + 0.7152 * c[1] + 0.0722 * c[2];
+    }
+
+} // namespace anonymous
+
+CpuAccumulator::CpuAccumulator(int width, int height)
+    : width_(0), height_(0), isMeanResolved_(false),
+      accumulatedCount_(0), activePixelCount_(0),
+      errorThreshold_(0), minFrameCount_(1)
+{
+    setSize(width, height);
+}
+
+void CpuAccumulator::setSize(int width, int height)
+{
+    width_  = width;
+    height_ = height;
+    mean_   = Image2D<Float4>();
+    clearHistory();
+}
+
+void CpuAccumulator::setAdaptiveSampling(
+    float errorThreshold, int minFrameCount) noexcept
+{
+    errorThreshold_ = errorThreshold;
+    minFrameCount_  = (std::max)(minFrameCount, 2);
+}
+
+void CpuAccumulator::clearHistory()
+{
+    const size_t texelCount = size_t(width_) * height_;
+
+    sums_.assign(3 * texelCount, 0.0);
+    isMeanResolved_ = false;
+
+    frameCounts_.assign(texelCount, 0);
+    luminanceM2_.assign(texelCount, 0.0);
+    activeMask_.assign(texelCount, 1);
+
+    accumulatedCount_ = 0;
+    activePixelCount_ = static_cast<int>(texelCount);
+}
+
+void CpuAccumulator::addNewFrame(const Image2D<Float4> &frame)
+{
+    assert(frame.width() == width_ && frame.height() == height_);
+
+    const int texelCount = width_ * height_;
+    const Float4 *newFrame = frame.raw_data();
+
+    for(int i = 0; i < texelCount; ++i)
+    {
+        if(activeMask_[i])
+            addPixel(i, newFrame[i]);
+    }
+
+    finishFrame();
+}
+
+void CpuAccumulator::addPixel(int i, const Float4 &value) noexcept
+{
+    // welford's update of m2, with means derived from the sums
+
+    const double oldLum = frameCounts_[i] > 0 ? getMeanLuminance(i) : 0.0;
+    const double newLum = luminance(value);
+
+    double *sum = &sums_[3 * size_t(i)];
+    sum[0] += value.x;
+    sum[1] += value.y;
+    sum[2] += value.z;
+    ++frameCounts_[i];
+
+    const double newMean = getMeanLuminance(i);
+    luminanceM2_[i] += (newLum - oldLum) * (newLum - newMean);
+}
+
+void CpuAccumulator::finishFrame()
+{
+    ++accumulatedCount_;
+    isMeanResolved_ = false;
+
+    if(errorThreshold_ > 0)
+        updateActiveMask();
+}
+
+Float4 CpuAccumulator::getPixelMean(int i) const noexcept
+{
+    const int count = frameCounts_[i];
+    if(!count)
+        return Float4(0);
+
+    const double *sum = &sums_[3 * size_t(i)];
+    const double invCount = 1.0 / count;
+    return Float4(
+        static_cast<float>(sum[0] * invCount),
+        static_cast<float>(sum[1] * invCount),
+        static_cast<float>(sum[2] * invCount),
+        1.0f);
+}
+
+const Image2D<Float4> &CpuAccumulator::getAccumulatedOutput() const
+{
+    if(!isMeanResolved_)
+    {
+        // allocated on demand, since renderers which tone map from the sums
+        // directly never need it
+
+        if(mean_.width() != width_ || mean_.height() != height_)
+            mean_ = Image2D<Float4>(height_, width_);
+
+        Float4 *mean = mean_.raw_data();
+        for(int i = 0; i < width_ * height_; ++i)
+            mean[i] = getPixelMean(i);
+
+        isMeanResolved_ = true;
+    }
+    return mean_;
+}
+
+int CpuAccumulator::getAccumulatedFrameCount() const noexcept
+{
+    return accumulatedCount_;
+}
+
+Image2D<float> CpuAccumulator::computeVariance() const
+{
+    const int w = width_;
+    const int h = height_;
+
+    Image2D<float> result(h, w);
+    float *data = result.raw_data();
+    for(int i = 0; i < w * h; ++i)
+    {
+        const int count = frameCounts_[i];
+        data[i] = count > 1 ?
+            static_cast<float>((std::max)(luminanceM2_[i], 0.0) /
+                               (double(count - 1) * count)) :
+            std::numeric_limits<float>::max();
+    }
+
+    return result;
+}
+
+double CpuAccumulator::estimateRemainingPixelFrames(
+    int maxFrameCount) const noexcept
+{
+    const int texelCount = width_ * height_;
+
+    double result = 0;
+    for(int i = 0; i < texelCount; ++i)
+    {
+        if(!activeMask_[i])
+            continue;
+
+        const int count = frameCounts_[i];
+        if(count >= maxFrameCount)
+            continue;
+
+        double needed = maxFrameCount;
+        if(errorThreshold_ > 0 && count >= 2)
+        {
+            const double ratio = computeError(i) / errorThreshold_;
+            needed = (std::min)(needed, count * ratio * ratio);
+        }
+        needed = (std::max)(needed, double(minFrameCount_));
+        result += (std::max)(needed - count, 0.0);
+    }
+
+    return result;
+}
+
+void CpuAccumulator::updateActiveMask()
+{
+    // pixels whose early frames happen to agree (e.g. all of them missed a
+    // small light path) report a tiny error. testing the max error of the
+    // neighborhood keeps them active until their surroundings converge.
+
+    const int w = width_;
+    const int h = height_;
+
+    errors_.resize(size_t(w) * h);
+    neighborErrors_.resize(size_t(w) * h);
+
+    for(int i = 0; i < w * h; ++i)
+        errors_[i] = computeError(i);
+
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const int xBeg = (std::max)(x - ERROR_NEIGHBOR_RADIUS, 0);
+            const int xEnd = (std::min)(x + ERROR_NEIGHBOR_RADIUS + 1, w);
+
+            float maxError = 0;
+            for(int nx = xBeg; nx < xEnd; ++nx)
+                maxError = (std::max)(maxError, errors_[y * w + nx]);
+            neighborErrors_[y * w + x] = maxError;
+        }
+    }
+
+    for(int y = 0; y < h; ++y)
+    {
+        const int yBeg = (std::max)(y - ERROR_NEIGHBOR_RADIUS, 0);
+        const int yEnd = (std::min)(y + ERROR_NEIGHBOR_RADIUS + 1, h);
+
+        for(int x = 0; x < w; ++x)
+        {
+            const int i = y * w + x;
+            if(!activeMask_[i] || frameCounts_[i] < minFrameCount_)
+                continue;
+
+            float maxError = 0;
+            for(int ny = yBeg; ny < yEnd; ++ny)
+                maxError = (std::max)(maxError, neighborErrors_[ny * w + x]);
+
+            if(maxError <= errorThreshold_)
+            {
+                activeMask_[i] = 0;
+                --activePixelCount_;
+            }
+        }
+    }
+}
+
+float CpuAccumulator::computeError(int i) const noexcept
+{
+    const int count = frameCounts_[i];
+    if(count < 2)
+        return std::numeric_limits<float>::infinity();
+
+    const double variance = luminanceM2_[i] / (count - 1);
+    const double stdError = std::sqrt((std::max)(variance, 0.0) / count);
+    const double mean     = getMeanLuminance(i);
+    return static_cast<float>(
+        stdError / ((std::max)(mean, 0.0) + ERROR_LUMINANCE_BIAS));
+}
+
+double CpuAccumulator::getMeanLuminance(int i) const noexcept
+{
+    return luminance(&sums_[3 * size_t(i)]) / frameCounts_[i];
+}
+
+PCL_END
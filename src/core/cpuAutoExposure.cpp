@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+
+#include <pcl/core/cpuAutoExposure.h>
+
+PCL_BEGIN
+
+namespace
+{
+
+    // histogram range in stops. darker pixels fall into the first bin and
+    // brighter ones into the last.
+    constexpr float MIN_LOG_LUMINANCE = -16;
+    constexpr float MAX_LOG_LUMINANCE = 8;
+
+    // luminance mapped to by the target exposure
+    constexpr float MIDDLE_GREY = 0.18f;
+
+    float luminance(const Float4 &c) noexcept
+    {
+        return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+    }
+
+} // namespace anonymous
+
+CpuAutoExposure::CpuAutoExposure(ThreadPool &threadPool)
+    : updateInterval_(DEFAULT_UPDATE_INTERVAL),
+      lowPercentile_(DEFAULT_LOW_PERCENTILE),
+      highPercentile_(DEFAULT_HIGH_PERCENTILE),
+      adaptationSpeed_(DEFAULT_ADAPTATION_SPEED),
+      framesToUpdate_(0), hasExposure_(false),
+      logExposure_(0), logTarget_(0), histogram_{},
+      threadPool_(threadPool)
+{
+    threadHistograms_.resize(threadPool_.getThreadCount());
+}
+
+void CpuAutoExposure::setUpdateInterval(int frameCount) noexcept
+{
+    updateInterval_ = (std::max)(frameCount, 1);
+    framesToUpdate_ = (std::min)(framesToUpdate_, updateInterval_);
+}
+
+void CpuAutoExposure::setPercentiles(float low, float high) noexcept
+{
+    lowPercentile_  = agz::math::clamp(low, 0.0f, 1.0f);
+    highPercentile_ = agz::math::clamp(high, lowPercentile_, 1.0f);
+}
+
+void CpuAutoExposure::setAdaptationSpeed(float speed) noexcept
+{
+    adaptationSpeed_ = speed;
+}
+
+void CpuAutoExposure::reset() noexcept
+{
+    framesToUpdate_ = 0;
+    hasExposure_    = false;
+    logExposure_    = 0;
+}
+
+float CpuAutoExposure::update(
+    const CpuAccumulator &accumulator, float elapsedSeconds)
+{
+    if(--framesToUpdate_ <= 0)
+    {
+        logTarget_      = std::log2(computeTargetExposure(accumulator));
+        framesToUpdate_ = updateInterval_;
+    }
+
+    if(!hasExposure_ || adaptationSpeed_ <= 0)
+    {
+        logExposure_ = logTarget_;
+        hasExposure_ = true;
+    }
+    else
+    {
+        const float t = 1 - std::exp(-adaptationSpeed_ * elapsedSeconds);
+        logExposure_ += t * (logTarget_ - logExposure_);
+    }
+
+    return getExposure();
+}
+
+float CpuAutoExposure::getExposure() const noexcept
+{
+    return std::exp2(logExposure_);
+}
+
+float CpuAutoExposure::computeTargetExposure(
+    const CpuAccumulator &accumulator)
+{
+    buildHistogram(accumulator);
+
+    uint64_t total = 0;
+    for(uint32_t count : histogram_)
+        total += count;
+    if(!total)
+        return 1;
+
+    // average bin centers over [low, high) of the sorted pixels. a bin
+    // straddling a bound contributes only its pixels inside.
+
+    const double lowRank  = lowPercentile_ * static_cast<double>(total);
+    const double highRank = highPercentile_ * static_cast<double>(total);
+
+    constexpr float binSize =
+        (MAX_LOG_LUMINANCE - MIN_LOG_LUMINANCE) / BIN_COUNT;
+
+    double rank = 0, weightSum = 0, logSum = 0;
+    for(int i = 0; i < BIN_COUNT && rank < highRank; ++i)
+    {
+        const double binBeg = rank;
+        const double binEnd = rank + histogram_[i];
+        rank = binEnd;
+
+        const double weight =
+            (std::min)(binEnd, highRank) - (std::max)(binBeg, lowRank);
+        if(weight <= 0)
+            continue;
+
+        weightSum += weight;
+        logSum    += weight * (MIN_LOG_LUMINANCE + (i + 0.5f) * binSize);
+    }
+
+    // low == high selects the single bin containing that percentile
+
+    if(weightSum <= 0)
+    {
+        rank = 0;
+        for(int i = 0; i < BIN_COUNT; ++i)
+        {
+            rank += histogram_[i];
+            if(rank > lowRank || i == BIN_COUNT - 1)
+            {
+                weightSum = 1;
+                logSum    = MIN_LOG_LUMINANCE + (i + 0.5f) * binSize;
+                break;
+            }
+        }
+    }
+
+    const double logLuminance = logSum / weightSum;
+    return MIDDLE_GREY / static_cast<float>(std::exp2(logLuminance));
+}
+
+void CpuAutoExposure::buildHistogram(const CpuAccumulator &accumulator)
+{
+    const int w = accumulator.getWidth();
+    const int h = accumulator.getHeight();
+
+    constexpr float binScale =
+        BIN_COUNT / (MAX_LOG_LUMINANCE - MIN_LOG_LUMINANCE);
+
+    for(auto &hist : threadHistograms_)
+        hist.fill(0);
+
+    threadPool_.parallelFor(h, [&](int threadIndex, int y)
+    {
+        Histogram &hist = threadHistograms_[threadIndex];
+        for(int x = 0; x < w; ++x)
+        {
+            // pixels without frames, e.g. right after clearing, are ignored
+
+            if(!accumulator.getPixelFrameCount(x, y))
+                continue;
+
+            const float lum = luminance(accumulator.getPixelMean(y * w + x));
+            const float logLum =
+                std::log2((std::max)(1e-30f, lum)) - MIN_LOG_LUMINANCE;
+            const int bin = static_cast<int>(agz::math::clamp(
+                logLum * binScale, 0.0f, BIN_COUNT - 1.0f));
+            ++hist[bin];
+        }
+    });
+
+    histogram_.fill(0);
+    for(auto &hist : threadHistograms_)
+    {
+        for(int i = 0; i < BIN_COUNT; ++i)
+            histogram_[i] += hist[i];
+    }
+}
+
+PCL_END
@@ -0,0 +1,442 @@
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <limits>
+
+#include <pcl/core/cpuBSDFBatch.h>
+
+PCL_BEGIN
+
+#if defined(PCL_PACKET_AVX512) || defined(PCL_PACKET_AVX2)
+
+namespace
+{
+    // the kernels below are written once against these lane operations
+
+#if defined(PCL_PACKET_AVX512)
+
+    using FloatLanes = __m512;
+    using IntLanes   = __m512i;
+    using MaskLanes  = __mmask16;
+
+    FloatLanes load(const float *p) noexcept { return _mm512_loadu_ps(p); }
+
+    void store(float *p, FloatLanes v) noexcept { _mm512_storeu_ps(p, v); }
+
+    FloatLanes broadcast(float v) noexcept { return _mm512_set1_ps(v); }
+
+    FloatLanes add(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_add_ps(a, b);
+    }
+
+    FloatLanes sub(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_sub_ps(a, b);
+    }
+
+    FloatLanes mul(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_mul_ps(a, b);
+    }
+
+    FloatLanes div(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_div_ps(a, b);
+    }
+
+    FloatLanes sqrt(FloatLanes v) noexcept { return _mm512_sqrt_ps(v); }
+
+    FloatLanes minimum(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_min_ps(a, b);
+    }
+
+    FloatLanes maximum(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_max_ps(a, b);
+    }
+
+    FloatLanes abs(FloatLanes v) noexcept { return _mm512_abs_ps(v); }
+
+    FloatLanes floor(FloatLanes v) noexcept
+    {
+        return _mm512_roundscale_ps(
+            v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    }
+
+    MaskLanes less(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+    }
+
+    /**
+     * mask ? a : b
+     */
+    FloatLanes select(MaskLanes mask, FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm512_mask_blend_ps(mask, b, a);
+    }
+
+    IntLanes truncate(FloatLanes v) noexcept { return _mm512_cvttps_epi32(v); }
+
+    IntLanes broadcastInt(int v) noexcept { return _mm512_set1_epi32(v); }
+
+    IntLanes addInt(IntLanes a, IntLanes b) noexcept
+    {
+        return _mm512_add_epi32(a, b);
+    }
+
+    IntLanes mulInt(IntLanes a, IntLanes b) noexcept
+    {
+        return _mm512_mullo_epi32(a, b);
+    }
+
+    IntLanes clampInt(IntLanes v, IntLanes lo, IntLanes hi) noexcept
+    {
+        return _mm512_min_epi32(_mm512_max_epi32(v, lo), hi);
+    }
+
+    FloatLanes gather(const float *base, IntLanes index) noexcept
+    {
+        return _mm512_i32gather_ps(index, base, 4);
+    }
+
+#else
+
+    using FloatLanes = __m256;
+    using IntLanes   = __m256i;
+    using MaskLanes  = __m256;
+
+    FloatLanes load(const float *p) noexcept { return _mm256_loadu_ps(p); }
+
+    void store(float *p, FloatLanes v) noexcept { _mm256_storeu_ps(p, v); }
+
+    FloatLanes broadcast(float v) noexcept { return _mm256_set1_ps(v); }
+
+    FloatLanes add(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_add_ps(a, b);
+    }
+
+    FloatLanes sub(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_sub_ps(a, b);
+    }
+
+    FloatLanes mul(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_mul_ps(a, b);
+    }
+
+    FloatLanes div(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_div_ps(a, b);
+    }
+
+    FloatLanes sqrt(FloatLanes v) noexcept { return _mm256_sqrt_ps(v); }
+
+    FloatLanes minimum(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_min_ps(a, b);
+    }
+
+    FloatLanes maximum(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_max_ps(a, b);
+    }
+
+    FloatLanes abs(FloatLanes v) noexcept
+    {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+    }
+
+    FloatLanes floor(FloatLanes v) noexcept { return _mm256_floor_ps(v); }
+
+    MaskLanes less(FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+    }
+
+    /**
+     * mask ? a : b
+     */
+    FloatLanes select(MaskLanes mask, FloatLanes a, FloatLanes b) noexcept
+    {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+
+    IntLanes truncate(FloatLanes v) noexcept { return _mm256_cvttps_epi32(v); }
+
+    IntLanes broadcastInt(int v) noexcept { return _mm256_set1_epi32(v); }
+
+    IntLanes addInt(IntLanes a, IntLanes b) noexcept
+    {
+        return _mm256_add_epi32(a, b);
+    }
+
+    IntLanes mulInt(IntLanes a, IntLanes b) noexcept
+    {
+        return _mm256_mullo_epi32(a, b);
+    }
+
+    IntLanes clampInt(IntLanes v, IntLanes lo, IntLanes hi) noexcept
+    {
+        return _mm256_min_epi32(_mm256_max_epi32(v, lo), hi);
+    }
+
+    FloatLanes gather(const float *base, IntLanes index) noexcept
+    {
+        return _mm256_i32gather_ps(base, index, 4);
+    }
+
+#endif
+
+    FloatLanes lerp(FloatLanes a, FloatLanes b, FloatLanes t) noexcept
+    {
+        return add(a, mul(t, sub(b, a)));
+    }
+
+    /**
+     * fastAsin
+     */
+    FloatLanes asinLanes(FloatLanes x) noexcept
+    {
+        const FloatLanes p = add(
+            broadcast(1.5707288f), mul(x, add(
+            broadcast(-0.2121144f), mul(x, add(
+            broadcast(0.0742610f), mul(x, broadcast(-0.0187293f)))))));
+        return sub(
+            broadcast(1.5707963f),
+            mul(sqrt(maximum(broadcast(0), sub(broadcast(1), x))), p));
+    }
+
+    /**
+     * fastSinCos
+     */
+    void sinCosLanes(FloatLanes x, FloatLanes *s, FloatLanes *c) noexcept
+    {
+        const FloatLanes x2 = mul(x, x);
+        *s = mul(x, add(
+            broadcast(1), mul(x2, add(
+            broadcast(-1.0f / 6), mul(x2, add(
+            broadcast(1.0f / 120), mul(x2, broadcast(-1.0f / 5040))))))));
+        *c = add(
+            broadcast(1), mul(x2, add(
+            broadcast(-0.5f), mul(x2, add(
+            broadcast(1.0f / 24), mul(x2, add(
+            broadcast(-1.0f / 720), mul(x2, broadcast(1.0f / 40320)))))))));
+    }
+
+    /**
+     * texel indices and weight of a clamped linear lookup, as in
+     * JensenRhoDtSampler::sample
+     */
+    void locateLanes(
+        FloatLanes c, int n, IntLanes *i0, IntLanes *i1, FloatLanes *t) noexcept
+    {
+        const FloatLanes fc = sub(mul(c, broadcast(float(n))), broadcast(0.5f));
+        const FloatLanes fl = floor(fc);
+        *t = sub(fc, fl);
+
+        const IntLanes lo = broadcastInt(0);
+        const IntLanes hi = broadcastInt(n - 1);
+        const IntLanes i  = truncate(fl);
+        *i0 = clampInt(i, lo, hi);
+        *i1 = clampInt(addInt(i, broadcastInt(1)), lo, hi);
+    }
+
+} // namespace anonymous
+
+void jensenFresnelBatch(
+    const float *eta, const float *cosTheta, float *result) noexcept
+{
+    const FloatLanes zero = broadcast(0);
+    const FloatLanes one  = broadcast(1);
+
+    // rays leaving the paper see the inverse relative index
+
+    const FloatLanes cosI   = load(cosTheta);
+    const MaskLanes  inside = less(cosI, zero);
+    const FloatLanes c      = abs(cosI);
+    const FloatLanes e      = select(inside, div(one, load(eta)), load(eta));
+
+    const FloatLanes sinT = div(sqrt(maximum(zero, sub(one, mul(c, c)))), e);
+    const FloatLanes cosT = sqrt(maximum(zero, sub(one, mul(sinT, sinT))));
+
+    const FloatLanes ec   = mul(e, c);
+    const FloatLanes ecT  = mul(e, cosT);
+    const FloatLanes para = div(sub(ec, cosT), add(ec, cosT));
+    const FloatLanes perp = div(sub(c, ecT), add(c, ecT));
+    const FloatLanes f    = mul(
+        broadcast(0.5f), add(mul(para, para), mul(perp, perp)));
+
+    // total internal reflection
+    store(result, select(less(sinT, one), f, one));
+}
+
+void jensenDGGXBatch(
+    const float *cosThetaH, const float *m, float *result) noexcept
+{
+    const FloatLanes c  = load(cosThetaH);
+    const FloatLanes mm = load(m);
+    const FloatLanes m2 = mul(mm, mm);
+    const FloatLanes d  = add(
+        broadcast(1), mul(sub(m2, broadcast(1)), mul(c, c)));
+    store(result, div(m2, mul(broadcast(BSDF_PI), mul(d, d))));
+}
+
+void jensenSmithGGXBatch(
+    const float *tanTheta, const float *m, float *result) noexcept
+{
+    const FloatLanes root = mul(load(m), load(tanTheta));
+    store(result, div(
+        broadcast(2),
+        add(broadcast(1), sqrt(add(broadcast(1), mul(root, root))))));
+}
+
+void jensenHGBatch(
+    const float *cosIO, const float *g, float *result) noexcept
+{
+    const FloatLanes gg  = load(g);
+    const FloatLanes g2  = mul(gg, gg);
+    const FloatLanes dem = sub(
+        add(broadcast(1), g2), mul(mul(broadcast(2), gg), load(cosIO)));
+    store(result, div(
+        sub(broadcast(1), g2),
+        mul(mul(broadcast(4 * BSDF_PI), dem), sqrt(dem))));
+}
+
+void jensenAccessRhoDtBatch(
+    const JensenRhoDtSampler &rhoDt,
+    const float *cosTheta, const float *eta, const float *m,
+    float *result) noexcept
+{
+    const int    N    = rhoDt.getTable()->getSize();
+    const float *data = rhoDt.getTable()->getData();
+
+    const FloatLanes theta = asinLanes(
+        minimum(abs(load(cosTheta)), broadcast(1)));
+    const FloatLanes u = div(theta, broadcast(0.5f * BSDF_PI));
+    const FloatLanes v = div(
+        sub(load(eta), broadcast(JENSEN_RHO_DT_MIN_ETA)),
+        broadcast(JENSEN_RHO_DT_MAX_ETA - JENSEN_RHO_DT_MIN_ETA));
+    const FloatLanes w = load(m);
+
+    // the table is indexed by (m, eta, theta) from its fastest axis
+
+    IntLanes x0, x1, y0, y1, z0, z1;
+    FloatLanes tx, ty, tz;
+    locateLanes(w, N, &x0, &x1, &tx);
+    locateLanes(v, N, &y0, &y1, &ty);
+    locateLanes(u, N, &z0, &z1, &tz);
+
+    const IntLanes n = broadcastInt(N);
+    auto at = [&](IntLanes xi, IntLanes yi, IntLanes zi)
+    {
+        return gather(
+            data, addInt(mulInt(addInt(mulInt(zi, n), yi), n), xi));
+    };
+
+    const FloatLanes c00 = lerp(at(x0, y0, z0), at(x1, y0, z0), tx);
+    const FloatLanes c10 = lerp(at(x0, y1, z0), at(x1, y1, z0), tx);
+    const FloatLanes c01 = lerp(at(x0, y0, z1), at(x1, y0, z1), tx);
+    const FloatLanes c11 = lerp(at(x0, y1, z1), at(x1, y1, z1), tx);
+
+    store(result, lerp(lerp(c00, c10, ty), lerp(c01, c11, ty), tz));
+}
+
+void diffuseSampleZWeightedHemisphereBatch(
+    const float *u1, const float *u2,
+    float *x, float *y, float *z) noexcept
+{
+    const FloatLanes zero = broadcast(0);
+    const FloatLanes one  = broadcast(1);
+    const FloatLanes two  = broadcast(2);
+
+    const FloatLanes a = sub(mul(two, load(u1)), one);
+    const FloatLanes b = sub(mul(two, load(u2)), one);
+
+    // see diffuseSampleZWeightedHemisphere. the radius is the coordinate with
+    // the larger magnitude, and sin and cos swap roles with it.
+
+    const MaskLanes  useA   = less(abs(b), abs(a));
+    const FloatLanes radius = select(useA, a, b);
+    const FloatLanes other  = select(useA, b, a);
+
+    FloatLanes s, c;
+    sinCosLanes(mul(broadcast(0.25f * BSDF_PI), div(other, radius)), &s, &c);
+
+    const MaskLanes isCenter = less(
+        maximum(abs(a), abs(b)),
+        broadcast((std::numeric_limits<float>::min)()));
+    const FloatLanes samX =
+        select(isCenter, zero, mul(radius, select(useA, c, s)));
+    const FloatLanes samY =
+        select(isCenter, zero, mul(radius, select(useA, s, c)));
+
+    store(x, samX);
+    store(y, samY);
+    store(z, sqrt(maximum(
+        zero, sub(sub(one, mul(samX, samX)), mul(samY, samY)))));
+}
+
+#else
+
+void jensenFresnelBatch(
+    const float *eta, const float *cosTheta, float *result) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+        result[i] = jensenFresnel(eta[i], cosTheta[i]);
+}
+
+void jensenDGGXBatch(
+    const float *cosThetaH, const float *m, float *result) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+        result[i] = jensenDGGX(cosThetaH[i], m[i]);
+}
+
+void jensenSmithGGXBatch(
+    const float *tanTheta, const float *m, float *result) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+        result[i] = jensenSmithGGX(tanTheta[i], m[i]);
+}
+
+void jensenHGBatch(
+    const float *cosIO, const float *g, float *result) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+        result[i] = jensenHG(cosIO[i], g[i]);
+}
+
+void jensenAccessRhoDtBatch(
+    const JensenRhoDtSampler &rhoDt,
+    const float *cosTheta, const float *eta, const float *m,
+    float *result) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+    {
+        result[i] = jensenAccessRhoDt(
+            rhoDt, Float3(0, 0, cosTheta[i]), eta[i], m[i]);
+    }
+}
+
+void diffuseSampleZWeightedHemisphereBatch(
+    const float *u1, const float *u2,
+    float *x, float *y, float *z) noexcept
+{
+    for(int i = 0; i < BSDF_BATCH_SIZE; ++i)
+    {
+        const Float3 w = diffuseSampleZWeightedHemisphere({ u1[i], u2[i] });
+        x[i] = w.x;
+        y[i] = w.y;
+        z[i] = w.z;
+    }
+}
+
+#endif
+
+PCL_END
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+
+#include <pcl/core/cpuDenoiser.h>
+
+PCL_BEGIN
+
+namespace
+{
+
+    // b3 spline, 1/16 1/4 3/8 1/4 1/16
+    constexpr float KERNEL[3] = { 3.0f / 8, 1.0f / 4, 1.0f / 16 };
+
+    constexpr int KERNEL_RADIUS = 2;
+
+    constexpr float DEPTH_SIGMA  = 1;
+    constexpr float ALBEDO_SIGMA = 0.1f;
+
+    // albedo below this is not divided out
+    constexpr float MIN_ALBEDO = 0.01f;
+
+    constexpr float EPS = 1e-6f;
+
+    // bounds the variance of pixels with less than two frames
+    constexpr float MAX_VARIANCE = 1e10f;
+
+    float luminance(const Float3 &c) noexcept
+    {
+        return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+    }
+
+    Float3 getDemodulationAlbedo(const DenoiserFeature &feature) noexcept
+    {
+        return Float3(
+            (std::max)(feature.albedo.x, MIN_ALBEDO),
+            (std::max)(feature.albedo.y, MIN_ALBEDO),
+            (std::max)(feature.albedo.z, MIN_ALBEDO));
+    }
+
+} // namespace anonymous
+
+CpuDenoiser::CpuDenoiser(ThreadPool &threadPool)
+    : iterationCount_(5), luminanceSigma_(4), features_(nullptr),
+      threadPool_(threadPool)
+{
+
+}
+
+void CpuDenoiser::setIterationCount(int count) noexcept
+{
+    iterationCount_ = (std::max)(count, 0);
+}
+
+void CpuDenoiser::setLuminanceSigma(float sigma) noexcept
+{
+    luminanceSigma_ = sigma;
+}
+
+const Image2D<Float4> &CpuDenoiser::denoise(
+    const Image2D<Float4>          &color,
+    const Image2D<float>           &variance,
+    const Image2D<DenoiserFeature> &features)
+{
+    assert(color.size() == variance.size());
+    assert(color.size() == features.size());
+
+    const int w = color.width();
+    const int h = color.height();
+
+    if(ping_.size() != color.size())
+    {
+        ping_   = Image2D<Float4>(h, w);
+        pong_   = Image2D<Float4>(h, w);
+        output_ = Image2D<Float4>(h, w);
+    }
+
+    features_ = &features;
+
+    threadPool_.parallelFor(h, [&](int, int y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const Float3 albedo = getDemodulationAlbedo(features(y, x));
+            const Float4 &c = color(y, x);
+            const float albedoLum = luminance(albedo);
+            const float var = (std::min)(variance(y, x), MAX_VARIANCE);
+
+            ping_(y, x) = Float4(
+                c.x / albedo.x, c.y / albedo.y, c.z / albedo.z,
+                var / (albedoLum * albedoLum));
+        }
+    });
+
+    for(int i = 0; i < iterationCount_; ++i)
+    {
+        const int step = 1 << i;
+        threadPool_.parallelFor(h, [&](int, int y)
+        {
+            filterRow(y, step);
+        });
+        std::swap(ping_, pong_);
+    }
+
+    threadPool_.parallelFor(h, [&](int, int y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const Float3 albedo = getDemodulationAlbedo(features(y, x));
+            const Float4 &irr = ping_(y, x);
+            output_(y, x) = Float4(
+                irr.x * albedo.x, irr.y * albedo.y, irr.z * albedo.z,
+                color(y, x).w);
+        }
+    });
+
+    features_ = nullptr;
+    return output_;
+}
+
+void CpuDenoiser::filterRow(int y, int step) noexcept
+{
+    const int w = ping_.width();
+    const int h = ping_.height();
+    const Image2D<DenoiserFeature> &features = *features_;
+
+    for(int x = 0; x < w; ++x)
+    {
+        const DenoiserFeature &fp = features(y, x);
+        const Float4 &cp = ping_(y, x);
+        const float lp = luminance(Float3(cp.x, cp.y, cp.z));
+
+        const float lumScale = luminanceSigma_ * std::sqrt(
+            filterVariance(x, y, fp.layer)) + EPS;
+
+        Float3 sumColor;
+        float  sumVariance = 0;
+        float  sumWeight   = 0;
+
+        for(int dy = -KERNEL_RADIUS; dy <= KERNEL_RADIUS; ++dy)
+        {
+            const int qy = y + dy * step;
+            if(qy < 0 || qy >= h)
+                continue;
+
+            for(int dx = -KERNEL_RADIUS; dx <= KERNEL_RADIUS; ++dx)
+            {
+                const int qx = x + dx * step;
+                if(qx < 0 || qx >= w)
+                    continue;
+
+                const DenoiserFeature &fq = features(qy, qx);
+                if(fq.layer != fp.layer)
+                    continue;
+
+                const Float4 &cq = ping_(qy, qx);
+                const float lq = luminance(Float3(cq.x, cq.y, cq.z));
+
+                const Float3 da = fq.albedo - fp.albedo;
+
+                const float depthTerm =
+                    std::abs(fq.depth - fp.depth) / (DEPTH_SIGMA * step);
+                const float albedoTerm =
+                    dot(da, da) / (ALBEDO_SIGMA * ALBEDO_SIGMA);
+                const float lumTerm = std::abs(lq - lp) / lumScale;
+
+                const float weight =
+                    KERNEL[std::abs(dx)] * KERNEL[std::abs(dy)] *
+                    std::exp(-(depthTerm + albedoTerm + lumTerm));
+
+                sumColor    += weight * Float3(cq.x, cq.y, cq.z);
+                sumVariance += weight * weight * cq.w;
+                sumWeight   += weight;
+            }
+        }
+
+        // the center tap always has a positive weight
+
+        const Float3 c = sumColor / sumWeight;
+        pong_(y, x) = Float4(
+            c.x, c.y, c.z, sumVariance / (sumWeight * sumWeight));
+    }
+}
+
+float CpuDenoiser::filterVariance(int x, int y, int layer) const noexcept
+{
+    // 3x3 gaussian over the same layer, which stabilizes the luminance
+    // weights of the first levels
+
+    constexpr float GAUSSIAN[2] = { 1.0f / 2, 1.0f / 4 };
+
+    const int w = ping_.width();
+    const int h = ping_.height();
+    const Image2D<DenoiserFeature> &features = *features_;
+
+    float sum = 0, sumWeight = 0;
+    for(int dy = -1; dy <= 1; ++dy)
+    {
+        const int qy = y + dy;
+        if(qy < 0 || qy >= h)
+            continue;
+
+        for(int dx = -1; dx <= 1; ++dx)
+        {
+            const int qx = x + dx;
+            if(qx < 0 || qx >= w || features(qy, qx).layer != layer)
+                continue;
+
+            const float weight =
+                GAUSSIAN[std::abs(dx)] * GAUSSIAN[std::abs(dy)];
+            sum       += weight * ping_(qy, qx).w;
+            sumWeight += weight;
+        }
+    }
+
+    return (std::max)(sum / sumWeight, 0.0f);
+}
+
+PCL_END
@@ -0,0 +1,163 @@
+#include <cstring>
+
+#include <pcl/core/cpuToneMapper.h>
+
+PCL_BEGIN
+
+namespace
+{
+    // pixels are tone mapped in chunks, so that the aces curve is evaluated
+    // by a plain loop over floats which the compiler vectorizes
+    constexpr int CHUNK_SIZE = 64;
+
+    // linear values below 2^-20 are encoded to 0, and values from 1 on to
+    // 255. values in between index the gamma table by their exponent and the
+    // top 9 bits of their mantissa. a bucket spans less than 0.2% of its
+    // values, so the encoded byte differs from the exact one by at most 1.
+    constexpr int GAMMA_MIN_EXPONENT  = -20;
+    constexpr int GAMMA_MANTISSA_BITS = 9;
+    constexpr int GAMMA_SHIFT         = 23 - GAMMA_MANTISSA_BITS;
+    constexpr int GAMMA_TABLE_SIZE    =
+        -GAMMA_MIN_EXPONENT << GAMMA_MANTISSA_BITS;
+
+    constexpr uint32_t GAMMA_MIN_BITS =
+        static_cast<uint32_t>(127 + GAMMA_MIN_EXPONENT) << 23;
+    constexpr uint32_t GAMMA_ONE_BITS = 127u << 23;
+
+    class GammaTable
+    {
+    public:
+
+        GammaTable()
+        {
+            for(int i = 0; i < GAMMA_TABLE_SIZE; ++i)
+            {
+                // center of the bucket
+
+                const uint32_t bits =
+                    GAMMA_MIN_BITS +
+                    (static_cast<uint32_t>(i) << GAMMA_SHIFT) +
+                    (1u << (GAMMA_SHIFT - 1));
+                float x;
+                std::memcpy(&x, &bits, sizeof(x));
+
+                const float v = std::pow(x, 1 / 2.2f);
+                bytes_[i] = static_cast<uint8_t>(
+                    agz::math::clamp(v, 0.0f, 1.0f) * 255 + 0.5f);
+            }
+        }
+
+        uint8_t encode(float x) const noexcept
+        {
+            // max(0, x) also maps nan to 0
+
+            x = (std::max)(0.0f, x);
+            uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+
+            if(bits < GAMMA_MIN_BITS)
+                return 0;
+            if(bits >= GAMMA_ONE_BITS)
+                return 255;
+            return bytes_[(bits - GAMMA_MIN_BITS) >> GAMMA_SHIFT];
+        }
+
+    private:
+
+        uint8_t bytes_[GAMMA_TABLE_SIZE];
+    };
+
+    const GammaTable &getGammaTable()
+    {
+        static const GammaTable table;
+        return table;
+    }
+
+    float aces(float x) noexcept
+    {
+        constexpr float A = 2.51f;
+        constexpr float B = 0.03f;
+        constexpr float C = 2.43f;
+        constexpr float D = 0.59f;
+        constexpr float E = 0.14f;
+        return (x * (A * x + B)) / (x * (C * x + D) + E);
+    }
+
+    /**
+     * @brief tone map count (<= CHUNK_SIZE) pixels to linear ldr values
+     *
+     * alpha channels are mapped as well and ignored by the callers.
+     */
+    void mapChunk(
+        float exposure, const Float4 *hdr, int count, float *ldr) noexcept
+    {
+        static_assert(sizeof(Float4) == 4 * sizeof(float));
+
+        const float *input = &hdr[0].x;
+        for(int i = 0; i < 4 * count; ++i)
+            ldr[i] = aces(exposure * input[i]);
+    }
+
+} // namespace anonymous
+
+CpuToneMapper::CpuToneMapper()
+    : exposure_(1)
+{
+
+}
+
+void CpuToneMapper::setExposure(float exposure) noexcept
+{
+    exposure_ = exposure;
+}
+
+Image2D<agz::math::color3b> CpuToneMapper::render(
+    const Image2D<Float4> &hdrImg) const
+{
+    const GammaTable &gamma = getGammaTable();
+
+    Image2D<agz::math::color3b> output(hdrImg.height(), hdrImg.width());
+    const int texelCount = hdrImg.width() * hdrImg.height();
+
+    float ldr[4 * CHUNK_SIZE];
+    for(int beg = 0; beg < texelCount; beg += CHUNK_SIZE)
+    {
+        const int count = (std::min)(CHUNK_SIZE, texelCount - beg);
+        mapChunk(exposure_, hdrImg.raw_data() + beg, count, ldr);
+
+        agz::math::color3b *out = output.raw_data() + beg;
+        for(int i = 0; i < count; ++i)
+        {
+            out[i] = agz::math::color3b(
+                gamma.encode(ldr[4 * i]),
+                gamma.encode(ldr[4 * i + 1]),
+                gamma.encode(ldr[4 * i + 2]));
+        }
+    }
+
+    return output;
+}
+
+void CpuToneMapper::mapRGBA8(
+    const Float4 *hdr, uint32_t *rgba, int count) const noexcept
+{
+    const GammaTable &gamma = getGammaTable();
+
+    float ldr[4 * CHUNK_SIZE];
+    for(int beg = 0; beg < count; beg += CHUNK_SIZE)
+    {
+        const int chunkSize = (std::min)(CHUNK_SIZE, count - beg);
+        mapChunk(exposure_, hdr + beg, chunkSize, ldr);
+
+        for(int i = 0; i < chunkSize; ++i)
+        {
+            rgba[beg + i] =
+                 static_cast<uint32_t>(gamma.encode(ldr[4 * i]))            |
+                (static_cast<uint32_t>(gamma.encode(ldr[4 * i + 1])) << 8)  |
+                (static_cast<uint32_t>(gamma.encode(ldr[4 * i + 2])) << 16) |
+                (255u << 24);
+        }
+    }
+}
+
+PCL_END
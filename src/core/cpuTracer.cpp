@@ -0,0 +1,919 @@
+#include <algorithm>
+
+#include <pcl/core/cpuBSDFBatch.h>
+#include <pcl/core/cpuTracer.h>
+
+PCL_BEGIN
+
+namespace
+{
+    bool isFinite(const Float4 &v) noexcept
+    {
+        return std::isfinite(v.x) && std::isfinite(v.y) &&
+               std::isfinite(v.z) && std::isfinite(v.w);
+    }
+
+    float powerHeuristic(float pdf, float otherPdf) noexcept
+    {
+        const float p2 = pdf * pdf;
+        return p2 / (p2 + otherPdf * otherPdf);
+    }
+}
+
+CpuTracer::CpuTracer(
+    const Int2 &outputSize,
+    const Int3 &paperSize,
+    float       paperDistance,
+    int         spp,
+    int         threadCount)
+    : outputSize_(outputSize), paperSize_(paperSize),
+      paperDistance_(paperDistance), backLightDistance_(paperDistance),
+      spp_(spp), maxDepth_(DEFAULT_MAX_DEPTH),
+      rouletteDepth_(DEFAULT_ROULETTE_DEPTH),
+      samplerType_(SamplerType::Sobol), sampleIndex_(0), pixelMask_(nullptr),
+      envLight_(0.15f, 0.15f, 0.15f), eyeZ_(-1), useJensenTables_(false),
+      threadPool_(threadCount)
+{
+    setPaperSize(paperSize);
+    features_ = Image2D<DenoiserFeature>(outputSize_.y, outputSize_.x);
+}
+
+void CpuTracer::setPaperSize(const Int3 &paperSize)
+{
+    paperSize_ = paperSize;
+
+    const size_t texelCount = size_t(paperSize_.x) * paperSize_.y;
+    occupancy_.resize(paperSize_.x, paperSize_.y, paperSize_.z);
+    columns_.resize(paperSize_.x, paperSize_.y, paperSize_.z);
+    pyramid_.resize(paperSize_.x, paperSize_.y, paperSize_.z);
+    dirtyColumnLayers_.assign(paperSize_.z, false);
+    dirtyPyramidRects_.assign(paperSize_.z, TexelRect{});
+    paperColors_.assign(paperSize_.z, {});
+    paperMaterials_.assign(paperSize_.z, PaperMaterial{});
+    jensenTables_.assign(paperSize_.z, JensenBSDFTable{});
+    layerPassable_.assign(paperSize_.z, 1);
+    backLight_.assign(texelCount, Float3(0));
+    backLightSampler_.build(paperSize_.x, paperSize_.y, backLight_.data());
+}
+
+void CpuTracer::setOutputSize(const Int2 &newOutputSize)
+{
+    if(newOutputSize != outputSize_)
+    {
+        outputSize_ = newOutputSize;
+        output_   = Image2D<Float4>();
+        features_ = Image2D<DenoiserFeature>(outputSize_.y, outputSize_.x);
+        sampleIndex_ = 0;
+    }
+}
+
+void CpuTracer::setSPP(int spp) noexcept
+{
+    spp_ = spp;
+}
+
+void CpuTracer::setPaperData(int z, const Texel *data)
+{
+    const size_t texelCount = size_t(paperSize_.x) * paperSize_.y;
+    const TexelRect dirty = occupancy_.setLayer(z, data);
+    if(!dirty.isEmpty())
+    {
+        dirtyColumnLayers_[z] = true;
+        dirtyPyramidRects_[z].merge(dirty);
+    }
+
+    const bool isWhite = std::all_of(
+        data, data + texelCount, [](const Texel &texel)
+    {
+        return texel.r == 255 && texel.g == 255 && texel.b == 255;
+    });
+
+    auto &colors = paperColors_[z];
+    if(isWhite)
+    {
+        colors.clear();
+        colors.shrink_to_fit();
+        return;
+    }
+
+    colors.resize(texelCount);
+    for(size_t i = 0; i < texelCount; ++i)
+        colors[i] = agz::math::color3b(data[i].r, data[i].g, data[i].b);
+}
+
+void CpuTracer::setBackLightRadiance(const agz::math::color3f *data)
+{
+    for(size_t i = 0; i < backLight_.size(); ++i)
+        backLight_[i] = Float3(data[i].r, data[i].g, data[i].b);
+    backLightSampler_.build(paperSize_.x, paperSize_.y, backLight_.data());
+}
+
+void CpuTracer::setPaperDiffuse(int z, float reflectionRatio)
+{
+    auto &material = paperMaterials_[z];
+    material.type            = PaperMaterial::TYPE_DIFFUSE;
+    material.reflectionRatio = reflectionRatio;
+    jensenTables_[z].clear();
+    markLayerSolid(z);
+}
+
+void CpuTracer::setPaperJensen(
+    int z,
+    float gf, float gb, float wf, float wb,
+    float frontEta, float backEta,
+    float frontM, float backM,
+    float d, float sigmaS, float sigmaA,
+    const Float3 &diffusionAlbedo)
+{
+    auto &material = paperMaterials_[z];
+    material.type   = PaperMaterial::TYPE_JENSEN;
+    material.jensen = computeJensenMaterial(
+        gf, gb, wf, wb, frontEta, backEta, frontM, backM,
+        d, sigmaS, sigmaA, diffusionAlbedo);
+    if(useJensenTables_)
+        jensenTables_[z].build(rhoDt_, material.jensen);
+    markLayerSolid(z);
+}
+
+void CpuTracer::setPaperDistance(float distance) noexcept
+{
+    paperDistance_ = distance;
+}
+
+void CpuTracer::setBackLightDistance(float distance) noexcept
+{
+    backLightDistance_ = distance;
+}
+
+void CpuTracer::setEnvLight(const Float3 &envLight) noexcept
+{
+    envLight_ = envLight;
+}
+
+void CpuTracer::setEyeZ(float z) noexcept
+{
+    eyeZ_ = z;
+}
+
+void CpuTracer::render()
+{
+    if(output_.width() != outputSize_.x || output_.height() != outputSize_.y)
+        output_ = Image2D<Float4>(outputSize_.y, outputSize_.x);
+
+    renderFrame({});
+}
+
+void CpuTracer::renderAccumulated(
+    CpuAccumulator              &accumulator,
+    const CpuToneMapper         *toneMapper,
+    Image2D<uint32_t>           *display)
+{
+    assert(accumulator.getWidth()  == outputSize_.x &&
+           accumulator.getHeight() == outputSize_.y);
+    assert(!display || (toneMapper && display->size() == outputSize_));
+
+    FrameTarget target;
+    target.accumulator = &accumulator;
+    target.toneMapper  = toneMapper;
+    target.display     = display;
+    renderFrame(target);
+
+    accumulator.finishFrame();
+}
+
+void CpuTracer::renderFrame(const FrameTarget &target)
+{
+    const int tileCountX = (outputSize_.x + TILE_SIZE - 1) / TILE_SIZE;
+    const int tileCountY = (outputSize_.y + TILE_SIZE - 1) / TILE_SIZE;
+
+    updateOccupancy();
+
+    threadStatistics_.resize(threadPool_.getThreadCount());
+    for(auto &s : threadStatistics_)
+        s.clear();
+
+    const PaperStackView  stack           = getPaperStackView();
+    const TracePacketFunc tracePacketFunc = selectTracePacket();
+    threadPool_.parallelFor(
+        tileCountX * tileCountY, [&](int threadIndex, int tileIndex)
+    {
+        renderTile(
+            stack, tracePacketFunc, target, tileIndex,
+            threadStatistics_[threadIndex]);
+    });
+
+    for(auto &s : threadStatistics_)
+        statistics_.merge(s);
+
+    sampleIndex_ += static_cast<uint32_t>(spp_);
+}
+
+void CpuTracer::setJensenTableEnabled(bool enabled)
+{
+    useJensenTables_ = enabled;
+    for(int z = 0; z < paperSize_.z; ++z)
+    {
+        const auto &material = paperMaterials_[z];
+        if(enabled && material.type == PaperMaterial::TYPE_JENSEN)
+            jensenTables_[z].build(rhoDt_, material.jensen);
+        else
+            jensenTables_[z].clear();
+    }
+}
+
+void CpuTracer::setJensenRhoDt(std::shared_ptr<const JensenRhoDt> table)
+{
+    rhoDt_ = JensenRhoDtSampler(std::move(table));
+    setJensenTableEnabled(useJensenTables_);
+}
+
+void CpuTracer::setSamplerType(SamplerType type) noexcept
+{
+    samplerType_ = type;
+    sampleIndex_ = 0;
+}
+
+void CpuTracer::setSampleIndex(uint32_t index) noexcept
+{
+    sampleIndex_ = index;
+}
+
+uint32_t CpuTracer::getSampleIndex() const noexcept
+{
+    return sampleIndex_;
+}
+
+void CpuTracer::setPixelMask(const uint8_t *mask) noexcept
+{
+    pixelMask_ = mask;
+}
+
+void CpuTracer::setMaxDepth(int maxDepth) noexcept
+{
+    maxDepth_ = (std::max)(maxDepth, 1);
+}
+
+void CpuTracer::setRouletteDepth(int depth) noexcept
+{
+    rouletteDepth_ = (std::max)(depth, 0);
+}
+
+const PathStatistics &CpuTracer::getPathStatistics() const noexcept
+{
+    return statistics_;
+}
+
+void CpuTracer::clearPathStatistics() noexcept
+{
+    statistics_.clear();
+}
+
+const Image2D<Float4> &CpuTracer::getOutput() const noexcept
+{
+    return output_;
+}
+
+const Image2D<DenoiserFeature> &CpuTracer::getFeatures() const noexcept
+{
+    return features_;
+}
+
+ThreadPool &CpuTracer::getThreadPool() noexcept
+{
+    return threadPool_;
+}
+
+void CpuTracer::markLayerSolid(int z) noexcept
+{
+    if(layerPassable_[z])
+    {
+        layerPassable_[z]     = 0;
+        dirtyColumnLayers_[z] = true;
+    }
+}
+
+void CpuTracer::updateOccupancy()
+{
+    for(int z = 0; z < paperSize_.z; ++z)
+    {
+        if(dirtyColumnLayers_[z])
+        {
+            if(layerPassable_[z])
+                columns_.clearLayer(z);
+            else
+                columns_.setLayer(z, occupancy_);
+            dirtyColumnLayers_[z] = false;
+        }
+
+        pyramid_.setLayerEnabled(z, !layerPassable_[z]);
+
+        if(!dirtyPyramidRects_[z].isEmpty())
+        {
+            pyramid_.updateLayer(z, occupancy_, dirtyPyramidRects_[z]);
+            dirtyPyramidRects_[z] = TexelRect{};
+        }
+    }
+}
+
+Float3 CpuTracer::getPaperColor(int x, int y, int z) const noexcept
+{
+    auto &colors = paperColors_[z];
+    if(colors.empty())
+        return Float3(1);
+
+    const auto &c = colors[size_t(y) * paperSize_.x + x];
+    return Float3(c.r, c.g, c.b) * (1 / 255.0f);
+}
+
+const JensenBSDFTable *CpuTracer::getJensenTable(int z) const noexcept
+{
+    const auto &table = jensenTables_[z];
+    return table.isAvailable() ? &table : nullptr;
+}
+
+float CpuTracer::getBackLightZ() const noexcept
+{
+    return paperDistance_ * (paperSize_.z - 1) + backLightDistance_;
+}
+
+float CpuTracer::getBackLightPdf(
+    const Float3 &pos, const Float3 &dir) const noexcept
+{
+    if(dir.z <= 0)
+        return 0;
+
+    const float t = (getBackLightZ() - pos.z) / dir.z;
+    const float x = pos.x + t * dir.x;
+    const float y = pos.y + t * dir.y;
+
+    const int paperX = agz::math::clamp(
+        static_cast<int>(x / outputSize_.x * paperSize_.x),
+        0, paperSize_.x - 1);
+    const int paperY = agz::math::clamp(
+        static_cast<int>(y / outputSize_.y * paperSize_.y),
+        0, paperSize_.y - 1);
+
+    // light points are sampled uniformly within the selected texel
+
+    const float texelArea =
+        (static_cast<float>(outputSize_.x) / paperSize_.x) *
+        (static_cast<float>(outputSize_.y) / paperSize_.y);
+    const float areaPdf =
+        backLightSampler_.getTexelPdf(paperX, paperY) / texelArea;
+
+    return areaPdf * t * t / dir.z;
+}
+
+template<CpuTracer::MaterialSet Materials>
+bool CpuTracer::isDiffuse(const PaperMaterial &material) noexcept
+{
+    if constexpr(Materials == MaterialSet::Mixed)
+        return material.type == PaperMaterial::TYPE_DIFFUSE;
+    else
+        return Materials == MaterialSet::Diffuse;
+}
+
+CpuTracer::MaterialSet CpuTracer::getMaterialSet() const noexcept
+{
+    // hollow layers are never hit, so their materials are irrelevant
+
+    bool hasDiffuse = false, hasJensen = false;
+    for(int z = 0; z < paperSize_.z; ++z)
+    {
+        if(layerPassable_[z])
+            continue;
+        if(paperMaterials_[z].type == PaperMaterial::TYPE_DIFFUSE)
+            hasDiffuse = true;
+        else
+            hasJensen = true;
+    }
+
+    if(hasDiffuse && hasJensen)
+        return MaterialSet::Mixed;
+    return hasDiffuse ? MaterialSet::Diffuse : MaterialSet::Jensen;
+}
+
+CpuTracer::TracePacketFunc CpuTracer::selectTracePacket() const noexcept
+{
+    const bool perspective = eyeZ_ < 0;
+    switch(getMaterialSet())
+    {
+    case MaterialSet::Diffuse:
+        return perspective ?
+            &CpuTracer::tracePacket<MaterialSet::Diffuse, true> :
+            &CpuTracer::tracePacket<MaterialSet::Diffuse, false>;
+    case MaterialSet::Jensen:
+        return perspective ?
+            &CpuTracer::tracePacket<MaterialSet::Jensen, true> :
+            &CpuTracer::tracePacket<MaterialSet::Jensen, false>;
+    default:
+        return perspective ?
+            &CpuTracer::tracePacket<MaterialSet::Mixed, true> :
+            &CpuTracer::tracePacket<MaterialSet::Mixed, false>;
+    }
+}
+
+template<CpuTracer::MaterialSet Materials>
+Float3 CpuTracer::estimateBackLight(
+    const PaperStackView &stack, int z,
+    const Float3 &pos, const Float3 &wo,
+    const PaperMaterial &material, const JensenLobePdfs &lobes,
+    PathSampler &sampler) const noexcept
+{
+    int paperX, paperY;
+    float texelPdf;
+    backLightSampler_.sample(
+        randomFloat(sampler), &paperX, &paperY, &texelPdf);
+    if(texelPdf <= 0)
+        return Float3(0);
+
+    const Float2 jitter = sampler.next2D();
+    const float u = (paperX + jitter.x) / paperSize_.x;
+    const float v = (paperY + jitter.y) / paperSize_.y;
+    const Float3 lightPos(
+        u * outputSize_.x, v * outputSize_.y, getBackLightZ());
+
+    const Float3 toLight = lightPos - pos;
+    const float dist = toLight.length();
+    if(dist <= 0)
+        return Float3(0);
+    const Float3 wi = toLight / dist;
+
+    const Float3 &radiance = backLight_[size_t(paperY) * paperSize_.x + paperX];
+
+    Float3 bsdf;
+    float bsdfPdf;
+    if(isDiffuse<Materials>(material))
+    {
+        bsdf    = evalDiffuse(material.reflectionRatio, wo, wi);
+        bsdfPdf = pdfDiffuse(wo, wi);
+    }
+    else
+    {
+        const JensenBSDFTable *table = getJensenTable(z);
+        bsdf    = table ? table->eval(material.jensen, wo, wi) :
+                          evalJensen(rhoDt_, material.jensen, wo, wi);
+        bsdfPdf = pdfJensenLobes(material.jensen, lobes, wo, wi);
+    }
+
+    if(!isBackLightVisible(stack, z + 1, pos, lightPos))
+        return Float3(0);
+
+    const float lightPdf = getBackLightPdf(pos, wi);
+    if(lightPdf <= 0)
+        return Float3(0);
+
+    return radiance * bsdf * (std::abs(wi.z) / lightPdf)
+         * powerHeuristic(lightPdf, bsdfPdf);
+}
+
+PaperStackView CpuTracer::getPaperStackView() const noexcept
+{
+    PaperStackView stack;
+    stack.occupancy            = occupancy_.getData();
+    stack.occupancyWordsPerRow = occupancy_.getWordsPerRow();
+    stack.columns              = &columns_;
+    stack.pyramid              = &pyramid_;
+    stack.layerPassable        = layerPassable_.data();
+    stack.paperWidth           = paperSize_.x;
+    stack.paperHeight          = paperSize_.y;
+    stack.paperCount           = paperSize_.z;
+    stack.outputWidth          = static_cast<float>(outputSize_.x);
+    stack.outputHeight         = static_cast<float>(outputSize_.y);
+    stack.paperDistance        = paperDistance_;
+    stack.backLightDistance    = backLightDistance_;
+    stack.maxDepth             = maxDepth_;
+    return stack;
+}
+
+template<bool Perspective>
+void CpuTracer::generateCameraRay(
+    int x, int y, Float3 *ori, Float3 *dir) const noexcept
+{
+    if constexpr(!Perspective)
+    {
+        *ori = Float3(x + 0.5f, y + 0.5f, -1);
+        *dir = Float3(0, 0, 1);
+    }
+    else
+    {
+        *ori = Float3(
+            0.5f * outputSize_.x, 0.5f * outputSize_.y, eyeZ_ * outputSize_.x);
+        *dir = (Float3(x + 0.5f, y + 0.5f, 0) - *ori).normalize();
+    }
+}
+
+template<CpuTracer::MaterialSet Materials, bool Perspective>
+void CpuTracer::tracePacket(
+    const PaperStackView &stack,
+    const int *xs, int y, int laneCount,
+    PathSampler *samplers, Float4 *results,
+    DenoiserFeature *features,
+    PathStatistics &statistics) const noexcept
+{
+    RayPacket     packet;
+    TraversalHits hits;
+
+    Float3 coef[RAY_PACKET_SIZE];
+    Float3 radiance[RAY_PACKET_SIZE];
+    int    scatterDepth[RAY_PACKET_SIZE];
+
+    // last scattering vertex and the bsdf pdf of the direction sampled there,
+    // for weighting back light hits against next-event estimation
+    Float3 lastVertex[RAY_PACKET_SIZE];
+    float  lastBSDFPdf[RAY_PACKET_SIZE];
+
+    for(int i = 0; i < RAY_PACKET_SIZE; ++i)
+    {
+        Float3 ori, dir;
+        generateCameraRay<Perspective>(
+            xs[(std::min)(i, laneCount - 1)], y, &ori, &dir);
+
+        packet.oriX[i] = ori.x;
+        packet.oriY[i] = ori.y;
+        packet.oriZ[i] = ori.z;
+        packet.dirX[i] = dir.x;
+        packet.dirY[i] = dir.y;
+        packet.dirZ[i] = dir.z;
+
+        packet.planeZ[i] = 0;
+        packet.depth[i]  = 1;
+
+        hits.inctX[i]  = hits.inctY[i]  = hits.inctZ[i] = 0;
+        hits.paperX[i] = hits.paperY[i] = 0;
+        hits.event[i]  = TraversalEvent::None;
+
+        coef[i]         = Float3(1);
+        radiance[i]     = Float3(0);
+        scatterDepth[i] = 0;
+        lastBSDFPdf[i]  = 0;
+    }
+
+    uint32_t activeMask = (1u << laneCount) - 1;
+
+    auto finishPath = [&](int i, const Float4 &result, PathTermination reason)
+    {
+        results[i] = result;
+        activeMask &= ~(1u << i);
+        statistics.addPath(
+            reason, (std::min)(packet.depth[i], maxDepth_), scatterDepth[i]);
+    };
+
+    auto recordFeature = [&](int i, int layer, const Float3 &albedo, float z)
+    {
+        if(features && scatterDepth[i] == 0)
+            features[i] = { layer, albedo, z };
+    };
+
+    // per-lane state of the paper hits of one traversal round. the bsdf
+    // random numbers of all hits are drawn before any of them is sampled, so
+    // that the direction dependent terms are evaluated for the whole packet
+    // by the kernels in cpuBSDFBatch.h.
+
+    Float3     scatterWo[RAY_PACKET_SIZE];
+    Float3     scatterColor[RAY_PACKET_SIZE];
+    BSDFSample bsdfSamples[RAY_PACKET_SIZE];
+
+    float dirU[RAY_PACKET_SIZE]     = {};
+    float dirV[RAY_PACKET_SIZE]     = {};
+    float cosineX[RAY_PACKET_SIZE];
+    float cosineY[RAY_PACKET_SIZE];
+    float cosineZ[RAY_PACKET_SIZE];
+    float cosO[RAY_PACKET_SIZE]     = {};
+    float sideEta[RAY_PACKET_SIZE];
+    float sideM[RAY_PACKET_SIZE]    = {};
+    float fresnel[RAY_PACKET_SIZE];
+    float atto[RAY_PACKET_SIZE];
+
+    std::fill(sideEta, sideEta + RAY_PACKET_SIZE, 1.0f);
+
+    while(activeMask)
+    {
+        traversePacket(stack, packet, activeMask, hits);
+
+        uint32_t scatterMask = 0;
+
+        for(int i = 0; i < laneCount; ++i)
+        {
+            if(!(activeMask & (1u << i)))
+                continue;
+
+            switch(hits.event[i])
+            {
+            case TraversalEvent::Escaped:
+                recordFeature(i, -1, Float3(1), 0);
+                finishPath(
+                    i, Float4(radiance[i] + envLight_ * coef[i],
+                              packet.depth[i] == 1 ? 0.0f : 1.0f),
+                    PathTermination::Escaped);
+                continue;
+            case TraversalEvent::DepthExhausted:
+                recordFeature(i, -1, Float3(1), 0);
+                finishPath(
+                    i, Float4(radiance[i] + envLight_ * coef[i], 1),
+                    PathTermination::DepthExhausted);
+                continue;
+            case TraversalEvent::OutOfBounds:
+                recordFeature(i, -1, Float3(1), 0);
+                if(scatterDepth[i] > 0)
+                {
+                    finishPath(
+                        i, Float4(radiance[i], 1),
+                        PathTermination::OutOfBounds);
+                }
+                else
+                {
+                    const bool ox = xs[i] / 8 % 2 == 0;
+                    const bool oy = y / 8 % 2 == 0;
+                    const float v = ox ^ oy ? 0.4f : 0.1f;
+                    finishPath(
+                        i, Float4(v, v, v, 0), PathTermination::OutOfBounds);
+                }
+                continue;
+            case TraversalEvent::BackLight:
+            {
+                float weight = 1;
+                if(backLightSampler_.isAvailable() && lastBSDFPdf[i] > 0)
+                {
+                    const Float3 lastDir(
+                        packet.dirX[i], packet.dirY[i], packet.dirZ[i]);
+                    weight = powerHeuristic(
+                        lastBSDFPdf[i],
+                        getBackLightPdf(lastVertex[i], lastDir));
+                }
+
+                recordFeature(i, paperSize_.z, Float3(1), getBackLightZ());
+
+                const Float3 &light = backLight_[
+                    size_t(hits.paperY[i]) * paperSize_.x + hits.paperX[i]];
+                finishPath(
+                    i, Float4(radiance[i] + weight * coef[i] * light, 1),
+                    PathTermination::BackLight);
+                continue;
+            }
+            default:
+                break;
+            }
+
+            // solid paper texel
+
+            const int paperZ = packet.planeZ[i];
+            const PaperMaterial &paperMaterial = paperMaterials_[paperZ];
+
+            const Float3 rayDir(packet.dirX[i], packet.dirY[i], packet.dirZ[i]);
+            const Float3 wo = -rayDir.normalize();
+            const Float3 color = getPaperColor(
+                hits.paperX[i], hits.paperY[i], paperZ);
+
+            recordFeature(i, paperZ, color, hits.inctZ[i]);
+            ++scatterDepth[i];
+
+            // the lobe and hg component choices are drawn for every
+            // material, so that the direction always comes from the same
+            // 2d pair
+
+            samplers[i].setDimension(
+                static_cast<uint32_t>(scatterDepth[i] - 1) *
+                DIMENSIONS_PER_SCATTER + BSDF_DIMENSION);
+
+            BSDFSample &sample = bsdfSamples[i];
+            sample.lobe      = randomFloat(samplers[i]);
+            sample.component = randomFloat(samplers[i]);
+            sample.dir       = samplers[i].next2D();
+
+            dirU[i] = sample.dir.x;
+            dirV[i] = sample.dir.y;
+
+            if(!isDiffuse<Materials>(paperMaterial))
+            {
+                getJensenOutgoingSide(
+                    paperMaterial.jensen, wo, &sideEta[i], &sideM[i]);
+                cosO[i] = std::abs(wo.z);
+            }
+
+            scatterWo[i]    = wo;
+            scatterColor[i] = color;
+            scatterMask    |= 1u << i;
+        }
+
+        if(!scatterMask)
+            continue;
+
+        diffuseSampleZWeightedHemisphereBatch(
+            dirU, dirV, cosineX, cosineY, cosineZ);
+        if constexpr(Materials != MaterialSet::Diffuse)
+        {
+            jensenFresnelBatch(sideEta, cosO, fresnel);
+            jensenAccessRhoDtBatch(rhoDt_, cosO, sideEta, sideM, atto);
+        }
+
+        for(int i = 0; i < laneCount; ++i)
+        {
+            if(!(scatterMask & (1u << i)))
+                continue;
+
+            const int paperZ = packet.planeZ[i];
+            const PaperMaterial &paperMaterial = paperMaterials_[paperZ];
+
+            const bool isFront = packet.dirZ[i] > 0;
+
+            const Float3 &wo    = scatterWo[i];
+            const Float3 &color = scatterColor[i];
+            const Float3 inct(hits.inctX[i], hits.inctY[i], hits.inctZ[i]);
+
+            const uint32_t dimension =
+                static_cast<uint32_t>(scatterDepth[i] - 1) *
+                DIMENSIONS_PER_SCATTER;
+
+            BSDFSample &sample = bsdfSamples[i];
+            sample.cosineDir = Float3(cosineX[i], cosineY[i], cosineZ[i]);
+
+            JensenLobePdfs lobes;
+            if(!isDiffuse<Materials>(paperMaterial))
+            {
+                lobes = computeJensenLobePdfs(
+                    paperMaterial.jensen, fresnel[i], atto[i]);
+            }
+
+            // next-event estimation. only done when a bsdf sampled path could
+            // reach the back light within the depth limit as well, i.e. when
+            // one more segment is allowed.
+
+            const bool lightReachable = packet.depth[i] < maxDepth_;
+            if(backLightSampler_.isAvailable() && lightReachable)
+            {
+                samplers[i].setDimension(dimension + LIGHT_DIMENSION);
+                radiance[i] += coef[i] * color *
+                    estimateBackLight<Materials>(
+                        stack, paperZ, inct, wo, paperMaterial, lobes,
+                        samplers[i]);
+            }
+
+            // sample bsdf
+
+            Float3 dir, throughput;
+            if(isDiffuse<Materials>(paperMaterial))
+            {
+                sampleDiffuse(
+                    paperMaterial.reflectionRatio, isFront, wo,
+                    sample, &throughput, &dir);
+                lastBSDFPdf[i] = pdfDiffuse(wo, dir);
+            }
+            else
+            {
+                sampleJensenLobes(
+                    rhoDt_, getJensenTable(paperZ), paperMaterial.jensen,
+                    lobes, wo, sample, &throughput, &dir,
+                    &lastBSDFPdf[i]);
+            }
+            lastVertex[i] = inct;
+
+            if(lastBSDFPdf[i] <= 0)
+            {
+                finishPath(i, Float4(radiance[i], 1), PathTermination::Absorbed);
+                continue;
+            }
+
+            // next ray
+
+            coef[i] = coef[i] * color * throughput;
+
+            // russian roulette on the path throughput. the number is drawn
+            // before the depth test, so that all paths consume it
+
+            samplers[i].setDimension(dimension + ROULETTE_DIMENSION);
+            const float uRoulette = randomFloat(samplers[i]);
+
+            if(scatterDepth[i] > rouletteDepth_)
+            {
+                const float survival = (std::min)(
+                    1.0f, (std::max)({ coef[i].x, coef[i].y, coef[i].z }));
+                if(!(uRoulette < survival))
+                {
+                    finishPath(
+                        i, Float4(radiance[i], 1), PathTermination::Roulette);
+                    continue;
+                }
+                coef[i] = coef[i] / survival;
+            }
+
+            packet.dirX[i] = dir.x;
+            packet.dirY[i] = dir.y;
+            packet.dirZ[i] = dir.z;
+
+            packet.oriX[i] = hits.inctX[i];
+            packet.oriY[i] = hits.inctY[i];
+            packet.oriZ[i] = hits.inctZ[i] +
+                             (dir.z > 0 ? TRAVERSAL_EPS : -TRAVERSAL_EPS);
+
+            packet.planeZ[i] += dir.z > 0 ? 1 : -1;
+            packet.depth[i]  += 1;
+        }
+    }
+}
+
+void CpuTracer::renderTile(
+    const PaperStackView &stack, TracePacketFunc tracePacketFunc,
+    const FrameTarget &target, int tileIndex,
+    PathStatistics &statistics) noexcept
+{
+    const int tileCountX = (outputSize_.x + TILE_SIZE - 1) / TILE_SIZE;
+
+    const int xBeg = tileIndex % tileCountX * TILE_SIZE;
+    const int yBeg = tileIndex / tileCountX * TILE_SIZE;
+    const int xEnd = (std::min)(xBeg + TILE_SIZE, outputSize_.x);
+    const int yEnd = (std::min)(yBeg + TILE_SIZE, outputSize_.y);
+
+    // features are the same in all frames of an accumulated history
+    const bool writeFeatures =
+        !target.accumulator ||
+        target.accumulator->getAccumulatedFrameCount() == 0;
+
+    for(int y = yBeg; y < yEnd; ++y)
+    {
+        // packets are formed from the unmasked pixels of the row
+
+        int xs[TILE_SIZE];
+        int pixelCount = 0;
+        for(int x = xBeg; x < xEnd; ++x)
+        {
+            if(!pixelMask_ || pixelMask_[y * outputSize_.x + x])
+                xs[pixelCount++] = x;
+        }
+
+        for(int p = 0; p < pixelCount; p += RAY_PACKET_SIZE)
+        {
+            const int *packetXs  = xs + p;
+            const int  laneCount = (std::min)(RAY_PACKET_SIZE, pixelCount - p);
+
+            Float3 sums[RAY_PACKET_SIZE];
+
+            for(int s = 0; s < spp_; ++s)
+            {
+                PathSampler samplers[RAY_PACKET_SIZE];
+                for(int i = 0; i < laneCount; ++i)
+                {
+                    samplers[i] = PathSampler(
+                        samplerType_, packetXs[i], y,
+                        sampleIndex_ + static_cast<uint32_t>(s));
+                }
+
+                // primary rays are identical for all samples
+
+                Float4          singles[RAY_PACKET_SIZE];
+                DenoiserFeature features[RAY_PACKET_SIZE];
+                (this->*tracePacketFunc)(
+                    stack, packetXs, y, laneCount, samplers, singles,
+                    writeFeatures && s == 0 ? features : nullptr,
+                    statistics);
+
+                if(writeFeatures && s == 0)
+                {
+                    for(int i = 0; i < laneCount; ++i)
+                        features_(y, packetXs[i]) = features[i];
+                }
+
+                for(int i = 0; i < laneCount; ++i)
+                {
+                    const Float4 &single = singles[i];
+                    if(isFinite(single))
+                        sums[i] += Float3(single.x, single.y, single.z);
+                }
+            }
+
+            for(int i = 0; i < laneCount; ++i)
+            {
+                const Float4 value(sums[i] / static_cast<float>(spp_), 1.0f);
+                if(target.accumulator)
+                {
+                    target.accumulator->addPixel(
+                        y * outputSize_.x + packetXs[i], value);
+                }
+                else
+                    output_(y, packetXs[i]) = value;
+            }
+        }
+    }
+
+    // masked pixels are tone mapped as well, since display may be stale
+    // after the exposure changes
+
+    if(target.display)
+    {
+        Float4 means[TILE_SIZE];
+        for(int y = yBeg; y < yEnd; ++y)
+        {
+            const int rowBeg = y * outputSize_.x + xBeg;
+            for(int x = xBeg; x < xEnd; ++x)
+            {
+                means[x - xBeg] =
+                    target.accumulator->getPixelMean(rowBeg + x - xBeg);
+            }
+
+            target.toneMapper->mapRGBA8(
+                means, target.display->raw_data() + rowBeg, xEnd - xBeg);
+        }
+    }
+}
+
+PCL_END
@@ -0,0 +1,81 @@
+#include <pcl/core/jensenMaterial.h>
+
+PCL_BEGIN
+
+std::pair<Float3, Float3> computeRdAndTd(
+    int n, const Float3 &color,
+    float sigma_s, float sigma_a, float d,
+    float gf, float gb, float wf, float wb) noexcept
+{
+    const float sigma_s_bar = (1 - (wb * gb + wf * gf)) * sigma_s;
+    const float sigma_t_bar = sigma_a + sigma_s_bar;
+    const float alpha_bar = sigma_s_bar / sigma_t_bar;
+    const float sigma_tr = std::sqrt(3 * sigma_a * sigma_t_bar);
+
+    auto sign = [](float x) { return x > 0 ? 1.0f : -1.0f; };
+
+    const float l = 1 / sigma_t_bar;
+
+    const Float3 A = (Float3(1) + color) / (Float3(float(1.001)) - color);
+
+    const float D = 1 / (3 * sigma_t_bar);
+
+    const Float3 zb = 2 * A * D;
+
+    auto z_r_i = [&](int i) { return float(2) * i * (d + zb + zb) + l; };
+    auto z_v_i = [&](int i) { return float(2) * i * (d + zb + zb) - l - 2 * zb; };
+
+    Float3 Rd, Td;
+    for(int i = -n; i <= n; ++i)
+    {
+        const Float3 zri = z_r_i(i);
+        const Float3 zvi = z_v_i(i);
+
+        for(int c = 0; c < 3; ++c)
+        {
+            Rd[c] +=
+                sign(zri[c]) * std::exp(-sigma_tr * std::abs(zri[c]))
+              - sign(zvi[c]) * std::exp(-sigma_tr * std::abs(zvi[c]));
+
+            Td[c] +=
+                sign(d - zri[c]) * std::exp(-sigma_tr * std::abs(d - zri[c]))
+              - sign(d - zvi[c]) * std::exp(-sigma_tr * std::abs(d - zvi[c]));
+        }
+    }
+    Rd *= alpha_bar / 2;
+    Td *= alpha_bar / 2;
+
+    return { Rd, Td };
+}
+
+JensenMaterial computeJensenMaterial(
+    float gf, float gb, float wf, float wb,
+    float frontEta, float backEta,
+    float frontM, float backM,
+    float d, float sigmaS, float sigmaA,
+    const Float3 &diffusionAlbedo) noexcept
+{
+    d = (std::max)(0.05f, d);
+
+    const float sigmaT = sigmaS + sigmaA;
+    const float alpha  = sigmaS / sigmaT;
+    const float tauD   = d * sigmaT;
+
+    const auto [Rd, Td] = computeRdAndTd(
+        4, diffusionAlbedo, sigmaS, sigmaA, d, gf, gb, wf, wb);
+
+    JensenMaterial material;
+    material.etaFront = frontEta;
+    material.etaBack  = backEta;
+    material.mFront   = (std::max)(0.01f, frontM);
+    material.mBack    = (std::max)(0.01f, backM);
+    material.Rd       = Rd;
+    material.Td       = Td;
+    material.alpha    = alpha;
+    material.tauD     = tauD;
+    material.HGArg    = Float4(wf, gf, wb, gb);
+
+    return material;
+}
+
+PCL_END
@@ -0,0 +1,290 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+#include <pcl/core/cpuBSDF.h>
+#include <pcl/core/jensenRhoDt.h>
+#include <pcl/core/mappedFile.h>
+#include <pcl/core/threadPool.h>
+
+PCL_BEGIN
+
+namespace
+{
+    constexpr char     CACHE_MAGIC[]  = "PCLRHODT";
+    constexpr size_t   MAGIC_SIZE     = sizeof(CACHE_MAGIC) - 1;
+    constexpr uint32_t CACHE_VERSION  = 2;
+
+    struct CacheHeader
+    {
+        char     magic[MAGIC_SIZE];
+        uint32_t version;
+        int32_t  size;
+        int32_t  sampleCount;
+    };
+
+    static_assert(sizeof(CacheHeader) == 20, "unexpected cache header size");
+
+    size_t getTexelCount(int size) noexcept
+    {
+        return size_t(size) * size * size;
+    }
+
+    float radicalInverse2(uint32_t i) noexcept
+    {
+        i = (i << 16) | (i >> 16);
+        i = ((i & 0x00ff00ff) << 8) | ((i & 0xff00ff00) >> 8);
+        i = ((i & 0x0f0f0f0f) << 4) | ((i & 0xf0f0f0f0) >> 4);
+        i = ((i & 0x33333333) << 2) | ((i & 0xcccccccc) >> 2);
+        i = ((i & 0x55555555) << 1) | ((i & 0xaaaaaaaa) >> 1);
+        return static_cast<float>(i) * 2.3283064365386963e-10f;
+    }
+
+    /**
+     * hammersley point of the normal distribution. u1 selects the polar angle
+     * of wh, and the azimuth is stored as its sine and cosine since it does
+     * not depend on the texel.
+     */
+    struct NormalSample
+    {
+        float u1;
+        float cosPhi;
+        float sinPhi;
+    };
+
+    std::vector<NormalSample> generateNormalSamples(int sampleCount)
+    {
+        std::vector<NormalSample> samples(sampleCount);
+        for(int i = 0; i < sampleCount; ++i)
+        {
+            const float phi =
+                2 * BSDF_PI * radicalInverse2(static_cast<uint32_t>(i));
+            samples[i].u1     = (i + 0.5f) / sampleCount;
+            samples[i].cosPhi = std::cos(phi);
+            samples[i].sinPhi = std::sin(phi);
+        }
+        return samples;
+    }
+
+    /**
+     * 1 - integral of the direct reflection lobe times cos(theta_o). normals
+     * are importance sampled with pdf D(wh) * cos(theta_h), for which the
+     * estimator reduces to F * G * (wi.wh) / (cos(theta_i) * cos(theta_h)).
+     */
+    float estimateRhoDt(
+        float cosI, float eta, float m,
+        const std::vector<NormalSample> &samples)
+    {
+        const float sinI = std::sqrt((std::max)(0.0f, 1 - cosI * cosI));
+        const Float3 wi(sinI, 0, cosI);
+        const float m2 = m * m;
+        const float Gi = jensenSmithGGX(jensenTanTheta(wi), m);
+
+        double sum = 0;
+        for(auto &sample : samples)
+        {
+            const float u1   = sample.u1;
+            const float cosH = std::sqrt((1 - u1) / (1 + (m2 - 1) * u1));
+            const float sinH = std::sqrt((std::max)(0.0f, 1 - cosH * cosH));
+            const Float3 wh(
+                sinH * sample.cosPhi, sinH * sample.sinPhi, cosH);
+
+            const float cosIH = dot(wi, wh);
+            if(cosIH <= 0)
+                continue;
+
+            const Float3 wo = 2 * cosIH * wh - wi;
+            if(wo.z <= 0)
+                continue;
+
+            const float F = jensenFresnel(eta, cosIH);
+            const float G = Gi * jensenSmithGGX(jensenTanTheta(wo), m);
+
+            sum += F * G * cosIH / (cosI * cosH);
+        }
+
+        const float albedo = static_cast<float>(sum / samples.size());
+        return agz::math::clamp(1 - albedo, 0.0f, 1.0f);
+    }
+
+} // namespace anonymous
+
+JensenRhoDt::JensenRhoDt(int size, int sampleCount, std::vector<float> data)
+    : size_(size), sampleCount_(sampleCount), data_(nullptr),
+      ownedData_(std::move(data))
+{
+    if(size <= 0 || sampleCount <= 0 ||
+       ownedData_.size() != getTexelCount(size))
+        throw PCLException("invalid rho_dt table size");
+    data_ = ownedData_.data();
+}
+
+JensenRhoDt::JensenRhoDt(const std::string &cacheFilename)
+    : size_(0), sampleCount_(0), data_(nullptr)
+{
+    mappedFile_ = std::make_unique<MappedFile>(cacheFilename);
+
+    CacheHeader header;
+    if(mappedFile_->getSize() < sizeof(header))
+        throw PCLException("invalid rho_dt cache: " + cacheFilename);
+    std::memcpy(&header, mappedFile_->getData(), sizeof(header));
+
+    if(std::memcmp(header.magic, CACHE_MAGIC, MAGIC_SIZE) != 0 ||
+       header.version != CACHE_VERSION || header.size <= 0 ||
+       header.sampleCount <= 0)
+        throw PCLException("invalid rho_dt cache: " + cacheFilename);
+
+    const size_t expectedSize =
+        sizeof(header) + getTexelCount(header.size) * sizeof(float);
+    if(mappedFile_->getSize() != expectedSize)
+        throw PCLException("truncated rho_dt cache: " + cacheFilename);
+
+    size_        = header.size;
+    sampleCount_ = header.sampleCount;
+    data_ = reinterpret_cast<const float *>(
+        static_cast<const char *>(mappedFile_->getData()) + sizeof(header));
+}
+
+JensenRhoDt::~JensenRhoDt() = default;
+
+int JensenRhoDt::getSize() const noexcept
+{
+    return size_;
+}
+
+int JensenRhoDt::getSampleCount() const noexcept
+{
+    return sampleCount_;
+}
+
+const float *JensenRhoDt::getData() const noexcept
+{
+    return data_;
+}
+
+std::vector<float> computeJensenRhoDt(
+    int size, int sampleCount, ThreadPool &threadPool)
+{
+    if(size <= 0 || sampleCount <= 0)
+        throw PCLException("invalid rho_dt table parameters");
+
+    const auto samples = generateNormalSamples(sampleCount);
+    std::vector<float> data(getTexelCount(size));
+
+    threadPool.parallelFor(size * size, [&](int, int row)
+    {
+        const int z = row / size;
+        const int y = row % size;
+
+        const float elevation = (z + 0.5f) / size * (0.5f * BSDF_PI);
+        const float cosI      = std::sin(elevation);
+        const float eta       = JENSEN_RHO_DT_MIN_ETA +
+                                (y + 0.5f) / size *
+                                (JENSEN_RHO_DT_MAX_ETA - JENSEN_RHO_DT_MIN_ETA);
+
+        float *dst = &data[size_t(row) * size];
+        for(int x = 0; x < size; ++x)
+        {
+            const float m = (x + 0.5f) / size;
+            dst[x] = estimateRhoDt(cosI, eta, m, samples);
+        }
+    });
+
+    return data;
+}
+
+void saveJensenRhoDt(
+    const std::string &filename, int size, int sampleCount, const float *data)
+{
+    const std::filesystem::path path = std::filesystem::u8path(filename);
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+
+    std::error_code ec;
+    if(path.has_parent_path())
+        std::filesystem::create_directories(path.parent_path(), ec);
+
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, MAGIC_SIZE);
+    header.version     = CACHE_VERSION;
+    header.size        = size;
+    header.sampleCount = sampleCount;
+
+    {
+        std::ofstream fout(tmpPath, std::ios::binary | std::ios::trunc);
+        if(!fout)
+            throw PCLException("failed to create rho_dt cache: " + filename);
+
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char *>(data),
+                   std::streamsize(getTexelCount(size) * sizeof(float)));
+        if(!fout)
+            throw PCLException("failed to write rho_dt cache: " + filename);
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if(ec)
+    {
+        std::filesystem::remove(tmpPath, ec);
+        throw PCLException("failed to write rho_dt cache: " + filename);
+    }
+}
+
+std::string getJensenRhoDtCacheFilename(int size)
+{
+    return "./asset/cache/rho_dt_" + std::to_string(size) + ".bin";
+}
+
+std::shared_ptr<const JensenRhoDt> getJensenRhoDt(int size)
+{
+    static std::mutex mutex;
+    static std::map<int, std::shared_ptr<const JensenRhoDt>> tables;
+
+    std::lock_guard lk(mutex);
+
+    auto &table = tables[size];
+    if(table)
+        return table;
+
+    const std::string filename = getJensenRhoDtCacheFilename(size);
+    try
+    {
+        // tables written by pcl-rho-dt with fewer samples than the default
+        // are too noisy to be reused
+
+        auto cached = std::make_shared<JensenRhoDt>(filename);
+        if(cached->getSize() == size &&
+           cached->getSampleCount() >= JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT)
+        {
+            table = std::move(cached);
+            return table;
+        }
+    }
+    catch(const PCLException &)
+    {
+        // missing or invalid cache. regenerate it below
+    }
+
+    ThreadPool threadPool;
+    auto data = computeJensenRhoDt(
+        size, JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT, threadPool);
+
+    try
+    {
+        saveJensenRhoDt(
+            filename, size, JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT, data.data());
+    }
+    catch(const PCLException &)
+    {
+        // the cache is only an optimization. keep the computed table when
+        // the asset directory is read-only
+    }
+
+    table = std::make_shared<JensenRhoDt>(
+        size, JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT, std::move(data));
+    return table;
+}
+
+PCL_END
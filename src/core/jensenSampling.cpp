@@ -0,0 +1,215 @@
+#include <pcl/core/jensenSampling.h>
+
+PCL_BEGIN
+
+namespace
+{
+    constexpr float MIN_COSINE_LOBE_PDF = 0.05f;
+
+    // rough fit of the single scattered transmission albedo, which also
+    // accounts for hg samples leaving the transmission hemisphere
+    constexpr float SINGLE_ALBEDO_SCALE = 0.1f;
+
+    // below this |g| a henyey-greenstein lobe is sampled as isotropic
+    constexpr float MIN_HG_G = 1e-3f;
+
+    float average(const Float3 &v) noexcept
+    {
+        return (std::max)((v.x + v.y + v.z) * (1.0f / 3), 0.0f);
+    }
+
+    /**
+     * orthonormal basis (t, b, n). see "building an orthonormal basis,
+     * revisited" by duff et al.
+     */
+    void buildBasis(const Float3 &n, Float3 *t, Float3 *b) noexcept
+    {
+        const float sign = std::copysign(1.0f, n.z);
+        const float a = -1 / (sign + n.z);
+        const float c = n.x * n.y * a;
+        *t = Float3(1 + sign * n.x * n.x * a, sign * c, -sign * n.x);
+        *b = Float3(c, sign + n.y * n.y * a, -n.y);
+    }
+
+    /**
+     * pdf of sampling local reflected direction wi from local wo by the ggx
+     * normal distribution. both are in the upper hemisphere.
+     */
+    float pdfGGXReflection(const Float3 &wo, const Float3 &wi, float m) noexcept
+    {
+        const Float3 wh = (wi + wo).normalize();
+        const float dotOH = dot(wo, wh);
+        if(dotOH <= 0)
+            return 0;
+        return jensenDGGX(wh.z, m) * wh.z / (4 * dotOH);
+    }
+
+    Float3 sampleGGXReflection(
+        const Float3 &wo, float m, float u1, float u2) noexcept
+    {
+        const float m2       = m * m;
+        const float cosTheta = std::sqrt((1 - u1) / (1 + (m2 - 1) * u1));
+        const float sinTheta = std::sqrt(
+            (std::max)(0.0f, 1 - cosTheta * cosTheta));
+        const float phi      = 2 * BSDF_PI * u2;
+
+        const Float3 wh(
+            sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+        return 2 * dot(wo, wh) * wh - wo;
+    }
+
+    float pdfHGMixture(const Float4 &HGArg, float cosIO) noexcept
+    {
+        const float weightSum = HGArg.x + HGArg.z;
+        if(weightSum <= 0)
+            return 0;
+        return jensenP(cosIO, HGArg) / weightSum;
+    }
+
+    /**
+     * sample cos(wi, wo) of a single henyey-greenstein lobe
+     */
+    float sampleHGCos(float g, float u) noexcept
+    {
+        if(std::abs(g) < MIN_HG_G)
+            return 1 - 2 * u;
+        const float s = (1 - g * g) / (1 - g + 2 * g * u);
+        return agz::math::clamp((1 + g * g - s * s) / (2 * g), -1.0f, 1.0f);
+    }
+
+} // namespace anonymous
+
+JensenLobePdfs computeJensenLobePdfs(
+    const JensenMaterial &params, float fresnel, float atto) noexcept
+{
+    JensenLobePdfs lobes;
+    lobes.specular     = fresnel;
+    lobes.reflection   = atto * average(params.Rd);
+    lobes.transmission = atto * average(params.Td);
+    if(params.HGArg.x + params.HGArg.z > 0)
+    {
+        lobes.single = SINGLE_ALBEDO_SCALE * atto * params.alpha *
+                       (std::min)(params.tauD, 1.0f) * std::exp(-params.tauD);
+    }
+
+    float sum = lobes.specular + lobes.reflection +
+                lobes.transmission + lobes.single;
+    if(!(sum > 0))
+    {
+        lobes = JensenLobePdfs{};
+        lobes.reflection = lobes.transmission = 0.5f;
+        return lobes;
+    }
+
+    lobes.specular     /= sum;
+    lobes.reflection   /= sum;
+    lobes.transmission /= sum;
+    lobes.single       /= sum;
+
+    lobes.reflection   = (std::max)(lobes.reflection,   MIN_COSINE_LOBE_PDF);
+    lobes.transmission = (std::max)(lobes.transmission, MIN_COSINE_LOBE_PDF);
+
+    sum = lobes.specular + lobes.reflection +
+          lobes.transmission + lobes.single;
+    lobes.specular     /= sum;
+    lobes.reflection   /= sum;
+    lobes.transmission /= sum;
+    lobes.single       /= sum;
+
+    return lobes;
+}
+
+float pdfJensenLobes(
+    const JensenMaterial &params, const JensenLobePdfs &lobes,
+    const Float3 &wo, const Float3 &wi) noexcept
+{
+    const float cosinePdf = std::abs(wi.z) / BSDF_PI;
+
+    if(wo.z * wi.z > 0)
+    {
+        float eta, m;
+        getJensenOutgoingSide(params, wo, &eta, &m);
+
+        // local frame in which both directions are in the upper hemisphere
+        const float side = wo.z < 0 ? -1.0f : 1.0f;
+        const float ggxPdf = lobes.specular > 0 ?
+            pdfGGXReflection(side * wo, side * wi, m) : 0.0f;
+
+        return lobes.specular * ggxPdf + lobes.reflection * cosinePdf;
+    }
+
+    const float hgPdf = lobes.single > 0 ?
+        pdfHGMixture(params.HGArg, dot(wi, wo)) : 0.0f;
+
+    return lobes.transmission * cosinePdf + lobes.single * hgPdf;
+}
+
+void sampleJensenLobes(
+    const JensenRhoDtSampler &rhoDt, const JensenBSDFTable *table,
+    const JensenMaterial &params, const JensenLobePdfs &lobes,
+    const Float3 &wo, const BSDFSample &sample,
+    Float3 *coef, Float3 *wi, float *pdf) noexcept
+{
+    const float side = wo.z < 0 ? -1.0f : 1.0f;
+
+    const float   u          = sample.lobe;
+    const float   uComponent = sample.component;
+    const Float2 &uDir       = sample.dir;
+
+    if(u < lobes.specular)
+    {
+        float eta, m;
+        getJensenOutgoingSide(params, wo, &eta, &m);
+
+        *wi = side * sampleGGXReflection(side * wo, m, uDir.x, uDir.y);
+    }
+    else if(u < lobes.specular + lobes.reflection + lobes.transmission)
+    {
+        const bool isReflection =
+            u < lobes.specular + lobes.reflection;
+
+        Float3 samDir = sample.cosineDir;
+        samDir.z *= isReflection ? side : -side;
+        *wi = samDir;
+    }
+    else
+    {
+        const float weightSum = params.HGArg.x + params.HGArg.z;
+        const bool  useFirst  = uComponent * weightSum < params.HGArg.x;
+        const float g = useFirst ? params.HGArg.y : params.HGArg.w;
+
+        const float cosTheta = sampleHGCos(g, uDir.x);
+        const float sinTheta = std::sqrt(
+            (std::max)(0.0f, 1 - cosTheta * cosTheta));
+        const float phi = 2 * BSDF_PI * uDir.y;
+
+        Float3 t, b;
+        buildBasis(wo, &t, &b);
+        *wi = sinTheta * std::cos(phi) * t +
+              sinTheta * std::sin(phi) * b +
+              cosTheta * wo;
+    }
+
+    // ggx and hg strategies may leave the hemisphere of their lobe
+
+    const bool isReflection = wo.z * wi->z > 0;
+    const bool valid =
+        wi->z != 0 &&
+        (u < lobes.specular ? isReflection :
+         u < lobes.specular + lobes.reflection + lobes.transmission ? true :
+         !isReflection);
+
+    *pdf = valid ? pdfJensenLobes(params, lobes, wo, *wi) : 0.0f;
+    if(*pdf <= 0)
+    {
+        *pdf  = 0;
+        *coef = Float3(0);
+        return;
+    }
+
+    const Float3 bsdf = table ?
+        table->eval(params, wo, *wi) : evalJensen(rhoDt, params, wo, *wi);
+    *coef = bsdf * (std::abs(wi->z) / *pdf);
+}
+
+PCL_END
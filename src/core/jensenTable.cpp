@@ -0,0 +1,240 @@
+#include <pcl/core/cpuBSDFBatch.h>
+#include <pcl/core/jensenTable.h>
+
+PCL_BEGIN
+
+namespace
+{
+    /**
+     * texel centers of a table with n texels are at (i + 0.5) / n, and
+     * coordinates outside of them are clamped
+     */
+    void locate(float c, int n, int *i0, int *i1, float *t) noexcept
+    {
+        const float fc = c * n - 0.5f;
+        const float fl = std::floor(fc);
+        *t  = fc - fl;
+        *i0 = agz::math::clamp(static_cast<int>(fl), 0, n - 1);
+        *i1 = agz::math::clamp(static_cast<int>(fl) + 1, 0, n - 1);
+    }
+
+    float lerp(float a, float b, float t) noexcept
+    {
+        return a + t * (b - a);
+    }
+
+    float texelCenter(int i, int n) noexcept
+    {
+        return (i + 0.5f) / n;
+    }
+
+} // namespace anonymous
+
+void JensenBSDFTable::build(
+    const JensenRhoDtSampler &rhoDt, const JensenMaterial &params)
+{
+    constexpr int NT = COS_THETA_SIZE;
+    constexpr int NP = COS_PHI_SIZE;
+    constexpr int B  = BSDF_BATCH_SIZE;
+
+    // texels are evaluated in batches along cos(theta_o) and cos(theta)
+    static_assert(NT % B == 0 && RHO_DT_SIZE % B == 0);
+
+    const float etas[2] = { params.etaFront, params.etaBack };
+    const float ms[2]   = { params.mFront,   params.mBack   };
+
+    float sideEta[2][B], sideM[2][B];
+    for(int side : { FRONT, BACK })
+    {
+        std::fill(sideEta[side], sideEta[side] + B, etas[side]);
+        std::fill(sideM[side],   sideM[side]   + B, ms[side]);
+    }
+
+    for(int side : { FRONT, BACK })
+    {
+        auto &table = rhoDt_[side];
+        table.resize(RHO_DT_SIZE);
+
+        float cosTheta[B];
+        for(int beg = 0; beg < RHO_DT_SIZE; beg += B)
+        {
+            for(int j = 0; j < B; ++j)
+                cosTheta[j] = texelCenter(beg + j, RHO_DT_SIZE);
+            jensenAccessRhoDtBatch(
+                rhoDt, cosTheta, sideEta[side], sideM[side], &table[beg]);
+        }
+
+        directReflection_[side].resize(getLobeTexelCount());
+    }
+    singleTransmission_.resize(getLobeTexelCount());
+
+    float g1[B], g2[B];
+    std::fill(g1, g1 + B, params.HGArg.y);
+    std::fill(g2, g2 + B, params.HGArg.w);
+
+    Float3 wos[B];
+    float cosH[B], cosIH[B], tanO[B], cosIO[B];
+    float D[B], F[B], Go[B], hg1[B], hg2[B];
+
+    // wo is in the xz plane, and wi is rotated around z by the phi difference
+
+    for(int i = 0; i < NT; ++i)
+    {
+        const float cosI = texelCenter(i, NT);
+        const float sinI = std::sqrt(1 - cosI * cosI);
+
+        float Gi[2];
+        for(int side : { FRONT, BACK })
+        {
+            Gi[side] = jensenSmithGGX(
+                jensenTanTheta(Float3(0, 0, cosI)), ms[side]);
+        }
+
+        for(int p = 0; p < NP; ++p)
+        {
+            const float cosPhi = 2 * texelCenter(p, NP) - 1;
+            const float sinPhi = std::sqrt(1 - cosPhi * cosPhi);
+            const Float3 wi(sinI * cosPhi, sinI * sinPhi, cosI);
+            const Float3 wt(wi.x, wi.y, -wi.z);
+
+            for(int beg = 0; beg < NT; beg += B)
+            {
+                for(int j = 0; j < B; ++j)
+                {
+                    const float cosO = texelCenter(beg + j, NT);
+                    const float sinO = std::sqrt(1 - cosO * cosO);
+                    wos[j] = Float3(sinO, 0, cosO);
+
+                    const Float3 wh = (wi + wos[j]).normalize();
+                    cosH[j]  = wh.z;
+                    cosIH[j] = dot(wi, wh);
+                    tanO[j]  = jensenTanTheta(wos[j]);
+                    cosIO[j] = dot(wt, wos[j]);
+                }
+
+                // jensenDirectReflection
+
+                for(int side : { FRONT, BACK })
+                {
+                    jensenDGGXBatch(cosH, sideM[side], D);
+                    jensenFresnelBatch(sideEta[side], cosIH, F);
+                    jensenSmithGGXBatch(tanO, sideM[side], Go);
+
+                    for(int j = 0; j < B; ++j)
+                    {
+                        const float G = Gi[side] * Go[j];
+                        directReflection_[side][
+                            (size_t(i) * NT + beg + j) * NP + p] =
+                            cosI * wos[j].z *
+                            (D[j] * F[j] * G / (4 * cosI * wos[j].z));
+                    }
+                }
+
+                // jensenSingleScattered with jensenP of both hg lobes
+
+                jensenHGBatch(cosIO, g1, hg1);
+                jensenHGBatch(cosIO, g2, hg2);
+
+                for(int j = 0; j < B; ++j)
+                {
+                    const float singleP =
+                        params.HGArg.x * hg1[j] + params.HGArg.z * hg2[j];
+                    singleTransmission_[(size_t(i) * NT + beg + j) * NP + p] =
+                        cosI * wos[j].z *
+                        jensenSingleScattered(wt, wos[j], params, singleP);
+                }
+            }
+        }
+    }
+}
+
+void JensenBSDFTable::clear() noexcept
+{
+    for(int side : { FRONT, BACK })
+    {
+        directReflection_[side] = std::vector<float>();
+        rhoDt_[side]            = std::vector<float>();
+    }
+    singleTransmission_ = std::vector<float>();
+}
+
+bool JensenBSDFTable::isAvailable() const noexcept
+{
+    return !singleTransmission_.empty();
+}
+
+Float3 JensenBSDFTable::eval(
+    const JensenMaterial &params,
+    const Float3 &wo, const Float3 &wi) const noexcept
+{
+    const float cosI = std::abs(wi.z);
+    const float cosO = std::abs(wo.z);
+    const float cosProduct = cosI * cosO;
+    if(cosProduct <= 0)
+        return Float3(0);
+
+    const float sinProduct = std::sqrt(
+        (std::max)(0.0f, (1 - cosI * cosI) * (1 - cosO * cosO)));
+    const float cosPhi = sinProduct > 0 ?
+        agz::math::clamp(
+            (wi.x * wo.x + wi.y * wo.y) / sinProduct, -1.0f, 1.0f) : 1.0f;
+
+    if(wo.z * wi.z > 0)
+    {
+        const int side = wo.z < 0 ? FRONT : BACK;
+        const float direct = sampleLobe(
+            directReflection_[side], cosI, cosO, cosPhi) / cosProduct;
+        const float atti = sampleRhoDt(side, cosI);
+        const float atto = sampleRhoDt(side, cosO);
+        return Float3(direct) + atti * atto * (params.Rd / BSDF_PI);
+    }
+
+    const int sideI = wi.z < 0 ? FRONT : BACK;
+    const float atti = sampleRhoDt(sideI, cosI);
+    const float atto = sampleRhoDt(1 - sideI, cosO);
+    const float single = sampleLobe(
+        singleTransmission_, cosI, cosO, cosPhi) / cosProduct;
+    return atti * atto * (Float3(single) + params.Td / BSDF_PI);
+}
+
+size_t JensenBSDFTable::getLobeTexelCount() noexcept
+{
+    return size_t(COS_THETA_SIZE) * COS_THETA_SIZE * COS_PHI_SIZE;
+}
+
+float JensenBSDFTable::sampleLobe(
+    const std::vector<float> &lobe,
+    float cosI, float cosO, float cosPhi) const noexcept
+{
+    constexpr int NT = COS_THETA_SIZE;
+    constexpr int NP = COS_PHI_SIZE;
+
+    int i0, i1, o0, o1, p0, p1;
+    float ti, to, tp;
+    locate(cosI, NT, &i0, &i1, &ti);
+    locate(cosO, NT, &o0, &o1, &to);
+    locate(0.5f * cosPhi + 0.5f, NP, &p0, &p1, &tp);
+
+    auto at = [&](int i, int o, int p)
+    {
+        return lobe[(size_t(i) * NT + o) * NP + p];
+    };
+
+    const float c00 = lerp(at(i0, o0, p0), at(i0, o0, p1), tp);
+    const float c01 = lerp(at(i0, o1, p0), at(i0, o1, p1), tp);
+    const float c10 = lerp(at(i1, o0, p0), at(i1, o0, p1), tp);
+    const float c11 = lerp(at(i1, o1, p0), at(i1, o1, p1), tp);
+
+    return lerp(lerp(c00, c01, to), lerp(c10, c11, to), ti);
+}
+
+float JensenBSDFTable::sampleRhoDt(int side, float cosTheta) const noexcept
+{
+    int i0, i1;
+    float t;
+    locate(cosTheta, RHO_DT_SIZE, &i0, &i1, &t);
+    const auto &table = rhoDt_[side];
+    return lerp(table[i0], table[i1], t);
+}
+
+PCL_END
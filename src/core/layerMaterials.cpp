@@ -0,0 +1,35 @@
+#include <pcl/core/layerMaterials.h>
+
+PCL_BEGIN
+
+bool LayerMaterials::update(
+    RenderBackend &backend, const std::vector<JensenParams> &params)
+{
+    if(params.size() != uploadedHashes_.size())
+    {
+        uploadedHashes_.assign(params.size(), 0);
+        isUploaded_.assign(params.size(), false);
+    }
+
+    bool changed = false;
+    for(size_t z = 0; z < params.size(); ++z)
+    {
+        const uint64_t hash = hashJensenParams(params[z]);
+        if(isUploaded_[z] && uploadedHashes_[z] == hash)
+            continue;
+
+        setPaperJensen(backend, static_cast<int>(z), params[z]);
+        uploadedHashes_[z] = hash;
+        isUploaded_[z]     = true;
+        changed            = true;
+    }
+
+    return changed;
+}
+
+void LayerMaterials::invalidate() noexcept
+{
+    isUploaded_.assign(isUploaded_.size(), false);
+}
+
+PCL_END
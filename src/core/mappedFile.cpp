@@ -0,0 +1,111 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <pcl/core/mappedFile.h>
+
+PCL_BEGIN
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &filename)
+    : data_(nullptr), size_(0), file_(nullptr), mapping_(nullptr)
+{
+    const HANDLE file = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        throw PCLException("failed to open file: " + filename);
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+    {
+        CloseHandle(file);
+        throw PCLException("failed to map empty file: " + filename);
+    }
+
+    const HANDLE mapping = CreateFileMappingA(
+        file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping)
+    {
+        CloseHandle(file);
+        throw PCLException("failed to map file: " + filename);
+    }
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw PCLException("failed to map file: " + filename);
+    }
+
+    data_    = data;
+    size_    = static_cast<size_t>(size.QuadPart);
+    file_    = file;
+    mapping_ = mapping;
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filename)
+    : data_(nullptr), size_(0)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw PCLException("failed to open file: " + filename);
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        throw PCLException("failed to map empty file: " + filename);
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+        throw PCLException("failed to map file: " + filename);
+
+    data_ = data;
+    size_ = size;
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<void *>(data_), size_);
+}
+
+#endif
+
+const void *MappedFile::getData() const noexcept
+{
+    return data_;
+}
+
+size_t MappedFile::getSize() const noexcept
+{
+    return size_;
+}
+
+PCL_END
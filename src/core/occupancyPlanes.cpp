@@ -0,0 +1,100 @@
+#include <algorithm>
+
+#include <pcl/core/occupancyPlanes.h>
+
+PCL_BEGIN
+
+namespace
+{
+    /**
+     * pack row y and merge the changed words into dirty
+     */
+    template<typename IsSolid>
+    void packRow(
+        uint64_t *row, int width, int y,
+        TexelRect &dirty, IsSolid &&isSolid) noexcept
+    {
+        for(int xBeg = 0; xBeg < width; xBeg += OccupancyPlanes::BITS_PER_WORD)
+        {
+            const int xEnd = (std::min)(
+                xBeg + OccupancyPlanes::BITS_PER_WORD, width);
+
+            uint64_t word = 0;
+            for(int x = xBeg; x < xEnd; ++x)
+                word |= uint64_t(isSolid(x) ? 1 : 0) << (x - xBeg);
+
+            if(*row != word)
+            {
+                *row = word;
+                dirty.merge({ xBeg, y, xEnd, y + 1 });
+            }
+            ++row;
+        }
+    }
+
+} // namespace anonymous
+
+OccupancyPlanes::OccupancyPlanes() noexcept
+    : width_(0), height_(0), layerCount_(0), wordsPerRow_(0)
+{
+
+}
+
+OccupancyPlanes::OccupancyPlanes(int width, int height, int layerCount)
+    : OccupancyPlanes()
+{
+    resize(width, height, layerCount);
+}
+
+void OccupancyPlanes::resize(int width, int height, int layerCount)
+{
+    width_       = width;
+    height_      = height;
+    layerCount_  = layerCount;
+    wordsPerRow_ = (width + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    words_.assign(size_t(wordsPerRow_) * height_ * layerCount_, 0);
+}
+
+TexelRect OccupancyPlanes::setLayer(int z, const PaperTexel *data) noexcept
+{
+    TexelRect dirty;
+    for(int y = 0; y < height_; ++y)
+    {
+        const PaperTexel *src = data + size_t(y) * width_;
+        packRow(getMutableRow(y, z), width_, y, dirty, [&](int x)
+        {
+            return src[x].binary != 0;
+        });
+    }
+    return dirty;
+}
+
+TexelRect OccupancyPlanes::setLayer(
+    int z, const Image2D<uint8_t> &binary) noexcept
+{
+    assert(binary.width() == width_ && binary.height() == height_);
+
+    TexelRect dirty;
+    for(int y = 0; y < height_; ++y)
+    {
+        packRow(getMutableRow(y, z), width_, y, dirty, [&](int x)
+        {
+            return binary(y, x) != 0;
+        });
+    }
+    return dirty;
+}
+
+void OccupancyPlanes::clearLayer(int z) noexcept
+{
+    const size_t layerWords = size_t(wordsPerRow_) * height_;
+    std::fill_n(words_.begin() + layerWords * z, layerWords, uint64_t(0));
+}
+
+uint64_t *OccupancyPlanes::getMutableRow(int y, int z) noexcept
+{
+    return &words_[(size_t(z) * height_ + y) * wordsPerRow_];
+}
+
+PCL_END
@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include <pcl/core/occupancyPyramid.h>
+
+PCL_BEGIN
+
+namespace
+{
+    TileOccupancy combine(TileOccupancy a, TileOccupancy b) noexcept
+    {
+        return a == b ? a : TileOccupancy::Mixed;
+    }
+
+} // namespace anonymous
+
+OccupancyPyramid::OccupancyPyramid() noexcept
+    : width_(0), height_(0), layerCount_(0)
+{
+
+}
+
+void OccupancyPyramid::resize(int width, int height, int layerCount)
+{
+    width_      = width;
+    height_     = height;
+    layerCount_ = layerCount;
+
+    layerEnabled_.assign(layerCount, true);
+    levels_.clear();
+
+    const int maxSize = (std::max)(width, height);
+    for(int level = 0; level < MAX_LEVEL_COUNT; ++level)
+    {
+        const int shift = getTileShift(level);
+        if(level > 0 && ((maxSize - 1) >> (shift - 1)) == 0)
+            break;
+
+        Level l;
+        l.width  = (width  + (1 << shift) - 1) >> shift;
+        l.height = (height + (1 << shift) - 1) >> shift;
+        l.tiles.assign(
+            size_t(l.width) * l.height * layerCount, TileOccupancy::Hollow);
+        l.columns.resize(l.width, l.height, layerCount);
+
+        levels_.push_back(std::move(l));
+    }
+
+    solidTileColumns_.resize(
+        levels_[0].width, levels_[0].height, layerCount);
+}
+
+void OccupancyPyramid::setLayer(int z, const OccupancyPlanes &occupancy)
+{
+    updateLayer(z, occupancy, { 0, 0, width_, height_ });
+}
+
+void OccupancyPyramid::updateLayer(
+    int z, const OccupancyPlanes &occupancy, const TexelRect &dirty)
+{
+    updateRegion(z, dirty, [&](int x, int y)
+    {
+        return occupancy.isSolid(x, y, z);
+    });
+}
+
+void OccupancyPyramid::setLayerEnabled(int z, bool enabled)
+{
+    if(layerEnabled_[z] == enabled)
+        return;
+    layerEnabled_[z] = enabled;
+
+    for(int level = 0; level < getLevelCount(); ++level)
+    {
+        for(int y = 0; y < levels_[level].height; ++y)
+        {
+            for(int x = 0; x < levels_[level].width; ++x)
+                updateColumnBit(level, x, y, z);
+        }
+    }
+}
+
+template<typename IsSolid>
+void OccupancyPyramid::updateRegion(
+    int z, const TexelRect &dirty, IsSolid &&isSolid)
+{
+    if(dirty.isEmpty() || levels_.empty())
+        return;
+
+    // level 0: classify texels
+
+    const int baseShift = getTileShift(0);
+
+    int xBeg = dirty.xBeg >> baseShift;
+    int yBeg = dirty.yBeg >> baseShift;
+    int xEnd = ((dirty.xEnd - 1) >> baseShift) + 1;
+    int yEnd = ((dirty.yEnd - 1) >> baseShift) + 1;
+
+    for(int ty = yBeg; ty < yEnd; ++ty)
+    {
+        const int texelYBeg = ty << baseShift;
+        const int texelYEnd = (std::min)(height_, (ty + 1) << baseShift);
+
+        for(int tx = xBeg; tx < xEnd; ++tx)
+        {
+            const int texelXBeg = tx << baseShift;
+            const int texelXEnd = (std::min)(width_, (tx + 1) << baseShift);
+
+            int solidCount = 0;
+            for(int y = texelYBeg; y < texelYEnd; ++y)
+            {
+                for(int x = texelXBeg; x < texelXEnd; ++x)
+                    solidCount += isSolid(x, y) ? 1 : 0;
+            }
+
+            const int texelCount =
+                (texelXEnd - texelXBeg) * (texelYEnd - texelYBeg);
+
+            getMutableTile(0, tx, ty, z) =
+                solidCount == 0          ? TileOccupancy::Hollow :
+                solidCount == texelCount ? TileOccupancy::Solid :
+                                           TileOccupancy::Mixed;
+            updateColumnBit(0, tx, ty, z);
+        }
+    }
+
+    // upper levels: combine 2x2 children
+
+    for(int level = 1; level < getLevelCount(); ++level)
+    {
+        const Level &child = levels_[level - 1];
+
+        xBeg >>= 1;
+        yBeg >>= 1;
+        xEnd = ((xEnd - 1) >> 1) + 1;
+        yEnd = ((yEnd - 1) >> 1) + 1;
+
+        for(int ty = yBeg; ty < yEnd; ++ty)
+        {
+            for(int tx = xBeg; tx < xEnd; ++tx)
+            {
+                const int cxEnd = (std::min)(2 * tx + 2, child.width);
+                const int cyEnd = (std::min)(2 * ty + 2, child.height);
+
+                TileOccupancy result = getTile(level - 1, 2 * tx, 2 * ty, z);
+                for(int cy = 2 * ty; cy < cyEnd; ++cy)
+                {
+                    for(int cx = 2 * tx; cx < cxEnd; ++cx)
+                        result = combine(result, getTile(level - 1, cx, cy, z));
+                }
+
+                getMutableTile(level, tx, ty, z) = result;
+                updateColumnBit(level, tx, ty, z);
+            }
+        }
+    }
+}
+
+TileOccupancy &OccupancyPyramid::getMutableTile(
+    int level, int x, int y, int z) noexcept
+{
+    auto &l = levels_[level];
+    return l.tiles[(size_t(z) * l.height + y) * l.width + x];
+}
+
+void OccupancyPyramid::updateColumnBit(int level, int x, int y, int z) noexcept
+{
+    const TileOccupancy tile = getTile(level, x, y, z);
+    levels_[level].columns.setTexel(
+        x, y, z, layerEnabled_[z] && tile != TileOccupancy::Hollow);
+
+    if(level == 0)
+    {
+        solidTileColumns_.setTexel(
+            x, y, z, layerEnabled_[z] && tile == TileOccupancy::Solid);
+    }
+}
+
+PCL_END
@@ -0,0 +1,1248 @@
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include <pcl/core/packetTraversal.h>
+
+PCL_BEGIN
+
+namespace
+{
+    // the simd kernels gather the 32-bit half of an occupancy word that
+    // contains the texel bit, which relies on little-endian words
+    constexpr int HALF_WORD_BITS = 32;
+
+    int toPaperCoord(float v, float outputSize, int paperSize) noexcept
+    {
+        return agz::math::clamp(
+            static_cast<int>(v / outputSize * paperSize), 0, paperSize - 1);
+    }
+
+    // keeps cell stay counts finite for rays moving straight along z
+    constexpr float MIN_TEXEL_STEP = 1e-20f;
+
+    bool isOutOfBounds(
+        const PaperStackView &stack, float x, float y) noexcept
+    {
+        return x < 0 || y < 0 ||
+               x > stack.outputWidth || y > stack.outputHeight;
+    }
+
+    /**
+     * number of cell columns levels which can be used for skipping: the
+     * texel columns followed by the tile columns of all pyramid levels
+     */
+    int getColumnLevelCount(const PaperStackView &stack) noexcept
+    {
+        return 1 + (stack.pyramid ? stack.pyramid->getLevelCount() : 0);
+    }
+
+    /**
+     * cell columns and log2 of the cell size of given level. columns is nullptr
+     * when the level is unavailable.
+     */
+    const PaperColumns *getColumnLevel(
+        const PaperStackView &stack, int level, int *cellShift) noexcept
+    {
+        if(level == 0)
+        {
+            *cellShift = 0;
+            return stack.columns;
+        }
+        *cellShift = stack.pyramid->getTileShift(level - 1);
+        return &stack.pyramid->getLevelColumns(level - 1);
+    }
+
+    /**
+     * whether texel (paperX, paperY) lies in a pyramid tile which is fully
+     * solid in layer z. such tiles are only marked in layers which are not
+     * passable.
+     */
+    bool isInSolidTile(
+        const PaperStackView &stack, int paperX, int paperY, int z) noexcept
+    {
+        const int tileShift = stack.pyramid->getTileShift(0);
+        const uint64_t *column = stack.pyramid->getSolidTileColumns().getColumn(
+            paperX >> tileShift, paperY >> tileShift);
+        return (column[z >> 6] >> (z & 63)) & 1;
+    }
+
+    /**
+     * skip the hollow planes the ray at lane i (which has just hit a hollow
+     * texel (paperX, paperY) at (x, y, z) of its current plane) crosses within
+     * a single cell of some column level. the longest such jump is taken.
+     *
+     * stepping through a plane moves the origin by stepEps along z only, so
+     * that the ray drifts by -stepEps * dir.xy / dir.z per skipped plane. the
+     * jump reproduces this by offsetting its origin by the accumulated drift.
+     */
+    bool tryColumnJump(
+        const PaperStackView &stack, RayPacket &packet, int i,
+        float x, float y, float z, int paperX, int paperY) noexcept
+    {
+        const int   planeZ  = packet.planeZ[i];
+        const bool  forward = packet.dirZ[i] > 0;
+        const int   stepZ   = forward ? 1 : -1;
+        const float stepEps = forward ? TRAVERSAL_EPS : -TRAVERSAL_EPS;
+
+        // position and movement between adjacent planes in texel space
+
+        const float u = x / stack.outputWidth * stack.paperWidth;
+        const float v = y / stack.outputHeight * stack.paperHeight;
+
+        const float planeStep =
+            (stack.paperDistance - TRAVERSAL_EPS) / std::abs(packet.dirZ[i]);
+        const float du = packet.dirX[i] * planeStep *
+                         (stack.paperWidth / stack.outputWidth);
+        const float dv = packet.dirY[i] * planeStep *
+                         (stack.paperHeight / stack.outputHeight);
+
+        const float maxStep = (std::max)(std::abs(du), std::abs(dv));
+
+        int bestSkipCount = 1;
+        int bestCellShift = 0;
+
+        for(int level = 0; level < getColumnLevelCount(stack); ++level)
+        {
+            int cellShift;
+            const PaperColumns *columns =
+                getColumnLevel(stack, level, &cellShift);
+            if(!columns)
+                continue;
+
+            // the ray leaves cells smaller than its step at the next plane
+            const float cellSize = static_cast<float>(1 << cellShift);
+            if(maxStep >= cellSize)
+                continue;
+
+            const int cellX = paperX >> cellShift;
+            const int cellY = paperY >> cellShift;
+
+            int skipCount = forward ?
+                columns->findNextSolidLayer(cellX, cellY, planeZ + 1) - planeZ :
+                planeZ - columns->findPrevSolidLayer(cellX, cellY, planeZ - 1);
+
+            // coarser cells can not contain longer hollow runs
+            if(skipCount <= bestSkipCount)
+                break;
+
+            // number of following planes at which the ray stays in the cell
+
+            const float cellU = static_cast<float>(cellX << cellShift);
+            const float cellV = static_cast<float>(cellY << cellShift);
+
+            const float distU = du > 0 ? cellU + cellSize - u : u - cellU;
+            const float distV = dv > 0 ? cellV + cellSize - v : v - cellV;
+            const float stayCount = (std::min)({
+                distU / (std::max)(std::abs(du), MIN_TEXEL_STEP),
+                distV / (std::max)(std::abs(dv), MIN_TEXEL_STEP),
+                static_cast<float>(skipCount - 1) });
+
+            skipCount = 1 + static_cast<int>(stayCount);
+            if(skipCount > bestSkipCount)
+            {
+                bestSkipCount = skipCount;
+                bestCellShift = cellShift;
+            }
+        }
+
+        if(bestSkipCount <= 1)
+            return false;
+
+        const int   lastZ = planeZ + (bestSkipCount - 1) * stepZ;
+        const float oriZ  = z + (bestSkipCount - 1) * stepEps;
+        const float lastT =
+            (stack.paperDistance * lastZ - oriZ) / packet.dirZ[i];
+
+        const float lastX  = x + lastT * packet.dirX[i];
+        const float lastY  = y + lastT * packet.dirY[i];
+        const float lastZf = oriZ + lastT * packet.dirZ[i];
+
+        if(isOutOfBounds(stack, lastX, lastY))
+            return false;
+
+        const int lastPaperX = toPaperCoord(
+            lastX, stack.outputWidth, stack.paperWidth);
+        const int lastPaperY = toPaperCoord(
+            lastY, stack.outputHeight, stack.paperHeight);
+
+        // cells are convex, so the ray stays in the cell at all planes in
+        // between. this also rejects jumps broken by rounding errors.
+        if((lastPaperX >> bestCellShift) != (paperX >> bestCellShift) ||
+           (lastPaperY >> bestCellShift) != (paperY >> bestCellShift))
+            return false;
+
+        packet.oriX[i]   = lastX;
+        packet.oriY[i]   = lastY;
+        packet.oriZ[i]   = lastZf + stepEps;
+        packet.planeZ[i] = lastZ + stepZ;
+        return true;
+    }
+
+} // namespace anonymous
+
+void traversePacketScalar(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept
+{
+    for(int i = 0; i < RAY_PACKET_SIZE; ++i)
+    {
+        if(!(activeMask & (1u << i)))
+            continue;
+
+        for(;;)
+        {
+            if(packet.depth[i] > stack.maxDepth)
+            {
+                hits.event[i] = TraversalEvent::DepthExhausted;
+                break;
+            }
+
+            const int planeZ = packet.planeZ[i];
+
+            float t = -1;
+            if(0 <= planeZ && planeZ <= stack.paperCount)
+            {
+                float dz = stack.paperDistance * planeZ - packet.oriZ[i];
+                if(planeZ >= stack.paperCount)
+                    dz += stack.backLightDistance - stack.paperDistance;
+                t = dz / packet.dirZ[i];
+            }
+
+            const float x = packet.oriX[i] + t * packet.dirX[i];
+            const float y = packet.oriY[i] + t * packet.dirY[i];
+            const float z = packet.oriZ[i] + t * packet.dirZ[i];
+
+            hits.inctX[i] = x;
+            hits.inctY[i] = y;
+            hits.inctZ[i] = z;
+
+            if(t <= TRAVERSAL_EPS)
+            {
+                hits.event[i] = TraversalEvent::Escaped;
+                break;
+            }
+
+            if(isOutOfBounds(stack, x, y))
+            {
+                hits.event[i] = TraversalEvent::OutOfBounds;
+                break;
+            }
+
+            const int paperX = toPaperCoord(
+                x, stack.outputWidth, stack.paperWidth);
+            const int paperY = toPaperCoord(
+                y, stack.outputHeight, stack.paperHeight);
+
+            hits.paperX[i] = paperX;
+            hits.paperY[i] = paperY;
+
+            if(planeZ >= stack.paperCount)
+            {
+                hits.event[i] = TraversalEvent::BackLight;
+                break;
+            }
+
+            // texels of fully solid tiles are not read
+
+            bool solid = stack.pyramid &&
+                         isInSolidTile(stack, paperX, paperY, planeZ);
+            if(!solid)
+            {
+                const size_t wordIndex =
+                    (size_t(planeZ) * stack.paperHeight + paperY)
+                  * stack.occupancyWordsPerRow + (paperX >> 6);
+                solid = ((stack.occupancy[wordIndex] >> (paperX & 63)) & 1) &&
+                        !stack.layerPassable[planeZ];
+            }
+
+            if(solid)
+            {
+                hits.event[i] = TraversalEvent::Paper;
+                break;
+            }
+
+            if(tryColumnJump(stack, packet, i, x, y, z, paperX, paperY))
+                continue;
+
+            const bool forward = packet.dirZ[i] > 0;
+            packet.oriX[i] = x;
+            packet.oriY[i] = y;
+            packet.oriZ[i] = z + (forward ? TRAVERSAL_EPS : -TRAVERSAL_EPS);
+            packet.planeZ[i] += forward ? 1 : -1;
+        }
+    }
+}
+
+bool isBackLightVisible(
+    const PaperStackView &stack, int planeZ,
+    const Float3 &ori, const Float3 &lightPos) noexcept
+{
+    const Float3 dir = lightPos - ori;
+    for(int z = (std::max)(planeZ, 0); z < stack.paperCount; ++z)
+    {
+        if(stack.layerPassable[z])
+            continue;
+
+        const float t = (stack.paperDistance * z - ori.z) / dir.z;
+        const float x = ori.x + t * dir.x;
+        const float y = ori.y + t * dir.y;
+
+        const int paperX = toPaperCoord(
+            x, stack.outputWidth, stack.paperWidth);
+        const int paperY = toPaperCoord(
+            y, stack.outputHeight, stack.paperHeight);
+
+        const size_t wordIndex =
+            (size_t(z) * stack.paperHeight + paperY)
+          * stack.occupancyWordsPerRow + (paperX >> 6);
+        if((stack.occupancy[wordIndex] >> (paperX & 63)) & 1)
+            return false;
+    }
+    return true;
+}
+
+#if defined(PCL_PACKET_AVX512)
+
+namespace
+{
+    /**
+     * exponent of v interpreted as unsigned integer. exact when v is a power
+     * of two or has no two adjacent bits set under its highest bit.
+     */
+    __m512i floorLog2(__m512i v) noexcept
+    {
+        const __m512i bits = _mm512_castps_si512(_mm512_cvtepu32_ps(v));
+        return _mm512_sub_epi32(
+            _mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127));
+    }
+
+    /**
+     * number of planes from planeZ which are hollow in the cell columns at
+     * (cellX, cellY). runs are followed across 32-layer half-words until a
+     * solid layer or the end of the stack. at least 1.
+     */
+    __m512i countHollowPlanes(
+        const PaperStackView &stack, const PaperColumns &columns,
+        __mmask16 lanes, __mmask16 forward,
+        __m512i cellX, __m512i cellY, __m512i planeZ, __m512i stepZ) noexcept
+    {
+        const __m512i izero     = _mm512_setzero_si512();
+        const __m512i ione      = _mm512_set1_epi32(1);
+        const __m512i halfBits  = _mm512_set1_epi32(HALF_WORD_BITS);
+        const __m512i lowMask   = _mm512_set1_epi32(HALF_WORD_BITS - 1);
+        const __m512i paperN    = _mm512_set1_epi32(stack.paperCount);
+
+        const __m512i columnHalf = _mm512_mullo_epi32(
+            _mm512_add_epi32(
+                _mm512_mullo_epi32(
+                    cellY, _mm512_set1_epi32(columns.getWidth())), cellX),
+            _mm512_set1_epi32(2 * columns.getWordsPerColumn()));
+
+        __m512i count  = ione;
+        __m512i queryZ = _mm512_add_epi32(planeZ, stepZ);
+
+        __mmask16 open = lanes;
+        for(;;)
+        {
+            open &= _mm512_cmpge_epi32_mask(queryZ, izero) &
+                    _mm512_cmplt_epi32_mask(queryZ, paperN);
+            if(!open)
+                break;
+
+            const __m512i halfWord = _mm512_mask_i32gather_epi32(
+                izero, open,
+                _mm512_add_epi32(columnHalf, _mm512_srli_epi32(queryZ, 5)),
+                columns.getData(), 4);
+
+            const __m512i shift     = _mm512_and_si512(queryZ, lowMask);
+            const __m512i halfBegin = _mm512_andnot_si512(lowMask, queryZ);
+
+            // forward: hollow planes from queryZ to the lowest solid layer
+
+            const __m512i above  = _mm512_srlv_epi32(halfWord, shift);
+            const __m512i lowest = _mm512_and_si512(
+                above, _mm512_sub_epi32(izero, above));
+            const __mmask16 forwardFound =
+                _mm512_cmpneq_epi32_mask(above, izero);
+            const __m512i forwardRun = _mm512_mask_blend_epi32(
+                forwardFound,
+                _mm512_sub_epi32(halfBits, shift), floorLog2(lowest));
+
+            // backward: hollow planes from queryZ to the highest solid layer
+
+            const __m512i below = _mm512_and_si512(
+                halfWord,
+                _mm512_srlv_epi32(
+                    _mm512_set1_epi32(-1), _mm512_sub_epi32(lowMask, shift)));
+            const __m512i highest = floorLog2(
+                _mm512_andnot_si512(_mm512_srli_epi32(below, 1), below));
+            const __mmask16 backwardFound =
+                _mm512_cmpneq_epi32_mask(below, izero);
+            const __m512i backwardRun = _mm512_mask_blend_epi32(
+                backwardFound,
+                _mm512_add_epi32(shift, ione),
+                _mm512_sub_epi32(shift, highest));
+
+            count = _mm512_mask_add_epi32(
+                count, open, count,
+                _mm512_mask_blend_epi32(forward, backwardRun, forwardRun));
+            queryZ = _mm512_mask_blend_epi32(
+                forward,
+                _mm512_sub_epi32(halfBegin, ione),
+                _mm512_add_epi32(halfBegin, halfBits));
+
+            open &= ~((forward & forwardFound) | (~forward & backwardFound));
+        }
+
+        // the back light plane ends forward runs
+        return _mm512_mask_min_epi32(
+            count, lanes & forward, count, _mm512_sub_epi32(paperN, planeZ));
+    }
+
+} // namespace anonymous
+
+void traversePacket(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept
+{
+    const __m512 eps        = _mm512_set1_ps(TRAVERSAL_EPS);
+    const __m512 zero       = _mm512_setzero_ps();
+    const __m512 outputW    = _mm512_set1_ps(stack.outputWidth);
+    const __m512 outputH    = _mm512_set1_ps(stack.outputHeight);
+    const __m512 paperWf    = _mm512_set1_ps(float(stack.paperWidth));
+    const __m512 paperHf    = _mm512_set1_ps(float(stack.paperHeight));
+    const __m512 paperDist  = _mm512_set1_ps(stack.paperDistance);
+    const __m512 lightDelta = _mm512_set1_ps(
+        stack.backLightDistance - stack.paperDistance);
+
+    const __m512i izero     = _mm512_setzero_si512();
+    const __m512i ione      = _mm512_set1_epi32(1);
+    const __m512i maxDepth  = _mm512_set1_epi32(stack.maxDepth);
+    const __m512i rowHalves = _mm512_set1_epi32(2 * stack.occupancyWordsPerRow);
+    const __m512i paperH    = _mm512_set1_epi32(stack.paperHeight);
+    const __m512i bitMask   = _mm512_set1_epi32(HALF_WORD_BITS - 1);
+    const __m512i paperWm1  = _mm512_set1_epi32(stack.paperWidth - 1);
+    const __m512i paperHm1  = _mm512_set1_epi32(stack.paperHeight - 1);
+    const __m512i paperN    = _mm512_set1_epi32(stack.paperCount);
+
+    __m512 oriX = _mm512_load_ps(packet.oriX);
+    __m512 oriY = _mm512_load_ps(packet.oriY);
+    __m512 oriZ = _mm512_load_ps(packet.oriZ);
+    const __m512 dirX = _mm512_load_ps(packet.dirX);
+    const __m512 dirY = _mm512_load_ps(packet.dirY);
+    const __m512 dirZ = _mm512_load_ps(packet.dirZ);
+
+    __m512i planeZ = _mm512_load_si512(packet.planeZ);
+    __m512i depth  = _mm512_load_si512(packet.depth);
+
+    __m512  hitX   = _mm512_load_ps(hits.inctX);
+    __m512  hitY   = _mm512_load_ps(hits.inctY);
+    __m512  hitZ   = _mm512_load_ps(hits.inctZ);
+    __m512i hitPX  = _mm512_load_si512(hits.paperX);
+    __m512i hitPY  = _mm512_load_si512(hits.paperY);
+    __m512i events = _mm512_load_si512(hits.event);
+
+    // step direction only depends on dirZ, which is fixed during traversal
+    const __mmask16 forward = _mm512_cmp_ps_mask(dirZ, zero, _CMP_GT_OQ);
+    const __m512 stepEps = _mm512_mask_blend_ps(
+        forward, _mm512_set1_ps(-TRAVERSAL_EPS), eps);
+    const __m512i stepZ = _mm512_mask_blend_epi32(
+        forward, _mm512_set1_epi32(-1), ione);
+
+    // movement between adjacent planes in texel space, for column skipping
+
+    const int columnLevelCount =
+        stack.columns || stack.pyramid ? getColumnLevelCount(stack) : 0;
+
+    const __m512 planeStep = _mm512_div_ps(
+        _mm512_sub_ps(paperDist, eps), _mm512_abs_ps(dirZ));
+    const __m512 du = _mm512_mul_ps(
+        _mm512_mul_ps(dirX, planeStep), _mm512_div_ps(paperWf, outputW));
+    const __m512 dv = _mm512_mul_ps(
+        _mm512_mul_ps(dirY, planeStep), _mm512_div_ps(paperHf, outputH));
+
+    const __mmask16 uForward = _mm512_cmp_ps_mask(du, zero, _CMP_GT_OQ);
+    const __mmask16 vForward = _mm512_cmp_ps_mask(dv, zero, _CMP_GT_OQ);
+
+    const __m512 minStep = _mm512_set1_ps(MIN_TEXEL_STEP);
+    const __m512 absDu = _mm512_max_ps(_mm512_abs_ps(du), minStep);
+    const __m512 absDv = _mm512_max_ps(_mm512_abs_ps(dv), minStep);
+    const __m512 maxStep = _mm512_max_ps(absDu, absDv);
+
+    __mmask16 active = static_cast<__mmask16>(activeMask);
+    while(active)
+    {
+        const __mmask16 exhausted =
+            _mm512_mask_cmpgt_epi32_mask(active, depth, maxDepth);
+        events = _mm512_mask_mov_epi32(
+            events, exhausted,
+            _mm512_set1_epi32(int32_t(TraversalEvent::DepthExhausted)));
+        active &= ~exhausted;
+
+        const __mmask16 validPlane =
+            _mm512_cmpge_epi32_mask(planeZ, izero) &
+            _mm512_cmple_epi32_mask(planeZ, paperN);
+        const __mmask16 isLight = _mm512_cmpge_epi32_mask(planeZ, paperN);
+
+        __m512 dz = _mm512_sub_ps(
+            _mm512_mul_ps(paperDist, _mm512_cvtepi32_ps(planeZ)), oriZ);
+        dz = _mm512_mask_add_ps(dz, isLight, dz, lightDelta);
+        const __m512 t = _mm512_mask_div_ps(
+            _mm512_set1_ps(-1), validPlane, dz, dirZ);
+
+        const __m512 x = _mm512_add_ps(oriX, _mm512_mul_ps(t, dirX));
+        const __m512 y = _mm512_add_ps(oriY, _mm512_mul_ps(t, dirY));
+        const __m512 z = _mm512_add_ps(oriZ, _mm512_mul_ps(t, dirZ));
+
+        hitX = _mm512_mask_mov_ps(hitX, active, x);
+        hitY = _mm512_mask_mov_ps(hitY, active, y);
+        hitZ = _mm512_mask_mov_ps(hitZ, active, z);
+
+        const __mmask16 escaped =
+            _mm512_mask_cmp_ps_mask(active, t, eps, _CMP_LE_OQ);
+        __mmask16 rest = active & ~escaped;
+
+        const __mmask16 oob = rest & (
+            _mm512_cmp_ps_mask(x, zero, _CMP_LT_OQ) |
+            _mm512_cmp_ps_mask(y, zero, _CMP_LT_OQ) |
+            _mm512_cmp_ps_mask(x, outputW, _CMP_GT_OQ) |
+            _mm512_cmp_ps_mask(y, outputH, _CMP_GT_OQ));
+        rest &= ~oob;
+
+        __m512i px = _mm512_cvttps_epi32(
+            _mm512_mul_ps(_mm512_div_ps(x, outputW), paperWf));
+        __m512i py = _mm512_cvttps_epi32(
+            _mm512_mul_ps(_mm512_div_ps(y, outputH), paperHf));
+        px = _mm512_min_epi32(_mm512_max_epi32(px, izero), paperWm1);
+        py = _mm512_min_epi32(_mm512_max_epi32(py, izero), paperHm1);
+
+        hitPX = _mm512_mask_mov_epi32(hitPX, rest, px);
+        hitPY = _mm512_mask_mov_epi32(hitPY, rest, py);
+
+        const __mmask16 light = rest & isLight;
+        rest &= ~light;
+
+        // texels of fully solid pyramid tiles are not read
+
+        __mmask16 solidTile = 0;
+        if(stack.pyramid)
+        {
+            const PaperColumns &tiles = stack.pyramid->getSolidTileColumns();
+            const __m128i tileShift =
+                _mm_cvtsi32_si128(stack.pyramid->getTileShift(0));
+
+            const __m512i tileHalf = _mm512_add_epi32(
+                _mm512_mullo_epi32(
+                    _mm512_add_epi32(
+                        _mm512_mullo_epi32(
+                            _mm512_srl_epi32(py, tileShift),
+                            _mm512_set1_epi32(tiles.getWidth())),
+                        _mm512_srl_epi32(px, tileShift)),
+                    _mm512_set1_epi32(2 * tiles.getWordsPerColumn())),
+                _mm512_srli_epi32(planeZ, 5));
+            const __m512i tileWord = _mm512_mask_i32gather_epi32(
+                izero, rest, tileHalf, tiles.getData(), 4);
+
+            solidTile = _mm512_mask_test_epi32_mask(
+                rest, tileWord,
+                _mm512_sllv_epi32(ione, _mm512_and_si512(planeZ, bitMask)));
+        }
+        const __mmask16 texel = rest & ~solidTile;
+
+        const __m512i halfIndex = _mm512_add_epi32(
+            _mm512_mullo_epi32(
+                _mm512_add_epi32(_mm512_mullo_epi32(planeZ, paperH), py),
+                rowHalves),
+            _mm512_srli_epi32(px, 5));
+        const __m512i halfWord = _mm512_mask_i32gather_epi32(
+            izero, texel, halfIndex, stack.occupancy, 4);
+        const __m512i passableLayer = _mm512_mask_i32gather_epi32(
+            izero, texel, planeZ, stack.layerPassable, 4);
+
+        const __m512i bit = _mm512_and_si512(
+            _mm512_srlv_epi32(halfWord, _mm512_and_si512(px, bitMask)), ione);
+        const __mmask16 solid = solidTile | (
+            _mm512_mask_cmpneq_epi32_mask(texel, bit, izero) &
+            _mm512_cmpeq_epi32_mask(passableLayer, izero));
+        const __mmask16 skip = rest & ~solid;
+        __mmask16 single = skip;
+
+        // skip runs of hollow planes within texel columns or pyramid tiles
+
+        if(columnLevelCount > 0 && skip)
+        {
+            const __m512 u = _mm512_mul_ps(_mm512_div_ps(x, outputW), paperWf);
+            const __m512 v = _mm512_mul_ps(_mm512_div_ps(y, outputH), paperHf);
+
+            __m512i bestSkipCount = ione;
+            __m512i bestCellShift = izero;
+
+            __mmask16 pending = skip;
+            for(int level = 0; pending && level < columnLevelCount; ++level)
+            {
+                int cellShift;
+                const PaperColumns *columns =
+                    getColumnLevel(stack, level, &cellShift);
+                if(!columns)
+                    continue;
+
+                // the ray leaves cells smaller than its step at the next plane
+                const __m512 cellSize = _mm512_set1_ps(float(1 << cellShift));
+                const __mmask16 candidates = _mm512_mask_cmp_ps_mask(
+                    pending, maxStep, cellSize, _CMP_LT_OQ);
+                if(!candidates)
+                    continue;
+
+                const __m128i shiftCount = _mm_cvtsi32_si128(cellShift);
+                const __m512i cellX = _mm512_srl_epi32(px, shiftCount);
+                const __m512i cellY = _mm512_srl_epi32(py, shiftCount);
+
+                const __m512i runCount = countHollowPlanes(
+                    stack, *columns, candidates, forward,
+                    cellX, cellY, planeZ, stepZ);
+
+                // coarser cells can not contain longer hollow runs
+                const __mmask16 improvable = _mm512_mask_cmpgt_epi32_mask(
+                    candidates, runCount, bestSkipCount);
+                pending = (pending & ~candidates) | improvable;
+                if(!improvable)
+                    continue;
+
+                // number of following planes at which the ray stays in the cell
+
+                const __m512 cellU = _mm512_cvtepi32_ps(
+                    _mm512_sll_epi32(cellX, shiftCount));
+                const __m512 cellV = _mm512_cvtepi32_ps(
+                    _mm512_sll_epi32(cellY, shiftCount));
+
+                const __m512 distU = _mm512_mask_blend_ps(
+                    uForward, _mm512_sub_ps(u, cellU),
+                    _mm512_sub_ps(_mm512_add_ps(cellU, cellSize), u));
+                const __m512 distV = _mm512_mask_blend_ps(
+                    vForward, _mm512_sub_ps(v, cellV),
+                    _mm512_sub_ps(_mm512_add_ps(cellV, cellSize), v));
+
+                const __m512 stayCount = _mm512_min_ps(
+                    _mm512_min_ps(
+                        _mm512_div_ps(distU, absDu),
+                        _mm512_div_ps(distV, absDv)),
+                    _mm512_cvtepi32_ps(_mm512_sub_epi32(runCount, ione)));
+                const __m512i skipCount = _mm512_add_epi32(
+                    ione, _mm512_cvttps_epi32(stayCount));
+
+                const __mmask16 better = _mm512_mask_cmpgt_epi32_mask(
+                    improvable, skipCount, bestSkipCount);
+                bestSkipCount = _mm512_mask_mov_epi32(
+                    bestSkipCount, better, skipCount);
+                bestCellShift = _mm512_mask_mov_epi32(
+                    bestCellShift, better, _mm512_set1_epi32(cellShift));
+            }
+
+            const __mmask16 multi =
+                _mm512_mask_cmpgt_epi32_mask(skip, bestSkipCount, ione);
+            if(multi)
+            {
+                const __m512i lastZ = _mm512_add_epi32(
+                    planeZ,
+                    _mm512_mullo_epi32(
+                        _mm512_sub_epi32(bestSkipCount, ione), stepZ));
+                const __m512 driftZ = _mm512_add_ps(z, _mm512_mul_ps(
+                    _mm512_cvtepi32_ps(_mm512_sub_epi32(bestSkipCount, ione)),
+                    stepEps));
+                const __m512 lastT = _mm512_div_ps(
+                    _mm512_sub_ps(
+                        _mm512_mul_ps(paperDist, _mm512_cvtepi32_ps(lastZ)),
+                        driftZ),
+                    dirZ);
+
+                const __m512 lx = _mm512_add_ps(x, _mm512_mul_ps(lastT, dirX));
+                const __m512 ly = _mm512_add_ps(y, _mm512_mul_ps(lastT, dirY));
+                const __m512 lz = _mm512_add_ps(
+                    driftZ, _mm512_mul_ps(lastT, dirZ));
+
+                const __mmask16 lastOob =
+                    _mm512_cmp_ps_mask(lx, zero, _CMP_LT_OQ) |
+                    _mm512_cmp_ps_mask(ly, zero, _CMP_LT_OQ) |
+                    _mm512_cmp_ps_mask(lx, outputW, _CMP_GT_OQ) |
+                    _mm512_cmp_ps_mask(ly, outputH, _CMP_GT_OQ);
+
+                __m512i lpx = _mm512_cvttps_epi32(
+                    _mm512_mul_ps(_mm512_div_ps(lx, outputW), paperWf));
+                __m512i lpy = _mm512_cvttps_epi32(
+                    _mm512_mul_ps(_mm512_div_ps(ly, outputH), paperHf));
+                lpx = _mm512_min_epi32(_mm512_max_epi32(lpx, izero), paperWm1);
+                lpy = _mm512_min_epi32(_mm512_max_epi32(lpy, izero), paperHm1);
+
+                // cells are convex, so the ray stays in the cell at all
+                // planes in between
+                const __mmask16 jump = multi & ~lastOob &
+                    _mm512_cmpeq_epi32_mask(
+                        _mm512_srlv_epi32(lpx, bestCellShift),
+                        _mm512_srlv_epi32(px, bestCellShift)) &
+                    _mm512_cmpeq_epi32_mask(
+                        _mm512_srlv_epi32(lpy, bestCellShift),
+                        _mm512_srlv_epi32(py, bestCellShift));
+
+                oriX   = _mm512_mask_mov_ps(oriX, jump, lx);
+                oriY   = _mm512_mask_mov_ps(oriY, jump, ly);
+                oriZ   = _mm512_mask_add_ps(oriZ, jump, lz, stepEps);
+                planeZ = _mm512_mask_add_epi32(planeZ, jump, lastZ, stepZ);
+
+                single &= ~jump;
+            }
+        }
+
+        events = _mm512_mask_mov_epi32(
+            events, escaped,
+            _mm512_set1_epi32(int32_t(TraversalEvent::Escaped)));
+        events = _mm512_mask_mov_epi32(
+            events, oob,
+            _mm512_set1_epi32(int32_t(TraversalEvent::OutOfBounds)));
+        events = _mm512_mask_mov_epi32(
+            events, light,
+            _mm512_set1_epi32(int32_t(TraversalEvent::BackLight)));
+        events = _mm512_mask_mov_epi32(
+            events, solid,
+            _mm512_set1_epi32(int32_t(TraversalEvent::Paper)));
+
+        oriX   = _mm512_mask_mov_ps(oriX, single, x);
+        oriY   = _mm512_mask_mov_ps(oriY, single, y);
+        oriZ   = _mm512_mask_add_ps(oriZ, single, z, stepEps);
+        planeZ = _mm512_mask_add_epi32(planeZ, single, planeZ, stepZ);
+
+        active = skip;
+    }
+
+    _mm512_store_ps(packet.oriX, oriX);
+    _mm512_store_ps(packet.oriY, oriY);
+    _mm512_store_ps(packet.oriZ, oriZ);
+    _mm512_store_si512(packet.planeZ, planeZ);
+    _mm512_store_si512(packet.depth, depth);
+
+    _mm512_store_ps(hits.inctX, hitX);
+    _mm512_store_ps(hits.inctY, hitY);
+    _mm512_store_ps(hits.inctZ, hitZ);
+    _mm512_store_si512(hits.paperX, hitPX);
+    _mm512_store_si512(hits.paperY, hitPY);
+    _mm512_store_si512(hits.event, events);
+}
+
+#elif defined(PCL_PACKET_AVX2)
+
+namespace
+{
+    __m256i maskToLanes(uint32_t mask) noexcept
+    {
+        const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_set1_epi32(int32_t(mask)), bits), bits);
+    }
+
+    __m256 asFloat(__m256i v) noexcept
+    {
+        return _mm256_castsi256_ps(v);
+    }
+
+    __m256i asInt(__m256 v) noexcept
+    {
+        return _mm256_castps_si256(v);
+    }
+
+    __m256i blendInt(__m256i a, __m256i b, __m256i mask) noexcept
+    {
+        return _mm256_blendv_epi8(a, b, mask);
+    }
+
+    __m256 blendFloat(__m256 a, __m256 b, __m256i mask) noexcept
+    {
+        return _mm256_blendv_ps(a, b, asFloat(mask));
+    }
+
+    /**
+     * exponent of v interpreted as unsigned integer. exact when v is a power
+     * of two or has no two adjacent bits set under its highest bit.
+     */
+    __m256i floorLog2(__m256i v) noexcept
+    {
+        // the signed conversion only works below bit 31
+        const __m256i bits = asInt(_mm256_cvtepi32_ps(
+            _mm256_and_si256(v, _mm256_set1_epi32(0x7fffffff))));
+        const __m256i exponent = _mm256_sub_epi32(
+            _mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+        return blendInt(
+            exponent, _mm256_set1_epi32(31),
+            _mm256_cmpgt_epi32(_mm256_setzero_si256(), v));
+    }
+
+    /**
+     * number of planes from planeZ which are hollow in the cell columns at
+     * (cellX, cellY). runs are followed across 32-layer half-words until a
+     * solid layer or the end of the stack. at least 1.
+     */
+    __m256i countHollowPlanes(
+        const PaperStackView &stack, const PaperColumns &columns,
+        __m256i lanes, __m256i forward,
+        __m256i cellX, __m256i cellY, __m256i planeZ, __m256i stepZ) noexcept
+    {
+        const __m256i izero    = _mm256_setzero_si256();
+        const __m256i ione     = _mm256_set1_epi32(1);
+        const __m256i minusOne = _mm256_set1_epi32(-1);
+        const __m256i halfBits = _mm256_set1_epi32(HALF_WORD_BITS);
+        const __m256i lowMask  = _mm256_set1_epi32(HALF_WORD_BITS - 1);
+        const __m256i paperN   = _mm256_set1_epi32(stack.paperCount);
+
+        const __m256i columnHalf = _mm256_mullo_epi32(
+            _mm256_add_epi32(
+                _mm256_mullo_epi32(
+                    cellY, _mm256_set1_epi32(columns.getWidth())), cellX),
+            _mm256_set1_epi32(2 * columns.getWordsPerColumn()));
+
+        __m256i count  = ione;
+        __m256i queryZ = _mm256_add_epi32(planeZ, stepZ);
+
+        __m256i open = lanes;
+        for(;;)
+        {
+            open = _mm256_and_si256(
+                open, _mm256_and_si256(
+                    _mm256_cmpgt_epi32(queryZ, minusOne),
+                    _mm256_cmpgt_epi32(paperN, queryZ)));
+            if(_mm256_testz_si256(open, open))
+                break;
+
+            const __m256i halfWord = _mm256_mask_i32gather_epi32(
+                izero, reinterpret_cast<const int *>(columns.getData()),
+                _mm256_add_epi32(columnHalf, _mm256_srli_epi32(queryZ, 5)),
+                open, 4);
+
+            const __m256i shift     = _mm256_and_si256(queryZ, lowMask);
+            const __m256i halfBegin = _mm256_andnot_si256(lowMask, queryZ);
+
+            // forward: hollow planes from queryZ to the lowest solid layer
+
+            const __m256i above  = _mm256_srlv_epi32(halfWord, shift);
+            const __m256i lowest = _mm256_and_si256(
+                above, _mm256_sub_epi32(izero, above));
+            const __m256i forwardEnd = _mm256_cmpeq_epi32(above, izero);
+            const __m256i forwardRun = blendInt(
+                floorLog2(lowest), _mm256_sub_epi32(halfBits, shift),
+                forwardEnd);
+
+            // backward: hollow planes from queryZ to the highest solid layer
+
+            const __m256i below = _mm256_and_si256(
+                halfWord,
+                _mm256_srlv_epi32(minusOne, _mm256_sub_epi32(lowMask, shift)));
+            const __m256i highest = floorLog2(
+                _mm256_andnot_si256(_mm256_srli_epi32(below, 1), below));
+            const __m256i backwardEnd = _mm256_cmpeq_epi32(below, izero);
+            const __m256i backwardRun = blendInt(
+                _mm256_sub_epi32(shift, highest),
+                _mm256_add_epi32(shift, ione), backwardEnd);
+
+            count = _mm256_add_epi32(
+                count, _mm256_and_si256(
+                    open, blendInt(backwardRun, forwardRun, forward)));
+            queryZ = blendInt(
+                _mm256_sub_epi32(halfBegin, ione),
+                _mm256_add_epi32(halfBegin, halfBits), forward);
+
+            // lanes whose run reached the end of the half-word continue
+            open = _mm256_and_si256(
+                open, blendInt(backwardEnd, forwardEnd, forward));
+        }
+
+        // the back light plane ends forward runs
+        return blendInt(
+            count,
+            _mm256_min_epi32(count, _mm256_sub_epi32(paperN, planeZ)),
+            _mm256_and_si256(lanes, forward));
+    }
+
+} // namespace anonymous
+
+void traversePacket(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept
+{
+    const __m256 eps        = _mm256_set1_ps(TRAVERSAL_EPS);
+    const __m256 zero       = _mm256_setzero_ps();
+    const __m256 outputW    = _mm256_set1_ps(stack.outputWidth);
+    const __m256 outputH    = _mm256_set1_ps(stack.outputHeight);
+    const __m256 paperWf    = _mm256_set1_ps(float(stack.paperWidth));
+    const __m256 paperHf    = _mm256_set1_ps(float(stack.paperHeight));
+    const __m256 paperDist  = _mm256_set1_ps(stack.paperDistance);
+    const __m256 lightDelta = _mm256_set1_ps(
+        stack.backLightDistance - stack.paperDistance);
+
+    const __m256i izero     = _mm256_setzero_si256();
+    const __m256i ione      = _mm256_set1_epi32(1);
+    const __m256i maxDepth  = _mm256_set1_epi32(stack.maxDepth);
+    const __m256i rowHalves = _mm256_set1_epi32(2 * stack.occupancyWordsPerRow);
+    const __m256i paperH    = _mm256_set1_epi32(stack.paperHeight);
+    const __m256i bitMask   = _mm256_set1_epi32(HALF_WORD_BITS - 1);
+    const __m256i paperWm1  = _mm256_set1_epi32(stack.paperWidth - 1);
+    const __m256i paperHm1  = _mm256_set1_epi32(stack.paperHeight - 1);
+    const __m256i paperN    = _mm256_set1_epi32(stack.paperCount);
+    const __m256i paperNp1  = _mm256_set1_epi32(stack.paperCount + 1);
+    const __m256i minusOne  = _mm256_set1_epi32(-1);
+
+    __m256 oriX = _mm256_load_ps(packet.oriX);
+    __m256 oriY = _mm256_load_ps(packet.oriY);
+    __m256 oriZ = _mm256_load_ps(packet.oriZ);
+    const __m256 dirX = _mm256_load_ps(packet.dirX);
+    const __m256 dirY = _mm256_load_ps(packet.dirY);
+    const __m256 dirZ = _mm256_load_ps(packet.dirZ);
+
+    auto loadInt = [](const void *p)
+    {
+        return _mm256_load_si256(static_cast<const __m256i *>(p));
+    };
+
+    __m256i planeZ = loadInt(packet.planeZ);
+    __m256i depth  = loadInt(packet.depth);
+
+    __m256  hitX   = _mm256_load_ps(hits.inctX);
+    __m256  hitY   = _mm256_load_ps(hits.inctY);
+    __m256  hitZ   = _mm256_load_ps(hits.inctZ);
+    __m256i hitPX  = loadInt(hits.paperX);
+    __m256i hitPY  = loadInt(hits.paperY);
+    __m256i events = loadInt(hits.event);
+
+    const __m256i forward = asInt(_mm256_cmp_ps(dirZ, zero, _CMP_GT_OQ));
+    const __m256 stepEps = blendFloat(
+        _mm256_set1_ps(-TRAVERSAL_EPS), eps, forward);
+    const __m256i stepZ = blendInt(minusOne, ione, forward);
+
+    // movement between adjacent planes in texel space, for column skipping
+
+    const int columnLevelCount =
+        stack.columns || stack.pyramid ? getColumnLevelCount(stack) : 0;
+
+    const __m256 absMask = asFloat(_mm256_set1_epi32(0x7fffffff));
+
+    const __m256 planeStep = _mm256_div_ps(
+        _mm256_sub_ps(paperDist, eps), _mm256_and_ps(dirZ, absMask));
+    const __m256 du = _mm256_mul_ps(
+        _mm256_mul_ps(dirX, planeStep), _mm256_div_ps(paperWf, outputW));
+    const __m256 dv = _mm256_mul_ps(
+        _mm256_mul_ps(dirY, planeStep), _mm256_div_ps(paperHf, outputH));
+
+    const __m256i uForward = asInt(_mm256_cmp_ps(du, zero, _CMP_GT_OQ));
+    const __m256i vForward = asInt(_mm256_cmp_ps(dv, zero, _CMP_GT_OQ));
+
+    const __m256 minStep = _mm256_set1_ps(MIN_TEXEL_STEP);
+    const __m256 absDu = _mm256_max_ps(_mm256_and_ps(du, absMask), minStep);
+    const __m256 absDv = _mm256_max_ps(_mm256_and_ps(dv, absMask), minStep);
+    const __m256 maxStep = _mm256_max_ps(absDu, absDv);
+
+    __m256i active = maskToLanes(activeMask);
+    while(!_mm256_testz_si256(active, active))
+    {
+        const __m256i exhausted = _mm256_and_si256(
+            active, _mm256_cmpgt_epi32(depth, maxDepth));
+        events = blendInt(
+            events,
+            _mm256_set1_epi32(int32_t(TraversalEvent::DepthExhausted)),
+            exhausted);
+        active = _mm256_andnot_si256(exhausted, active);
+
+        const __m256i validPlane = _mm256_and_si256(
+            _mm256_cmpgt_epi32(planeZ, minusOne),
+            _mm256_cmpgt_epi32(paperNp1, planeZ));
+        const __m256i isLight = _mm256_cmpgt_epi32(
+            planeZ, _mm256_sub_epi32(paperN, ione));
+
+        __m256 dz = _mm256_sub_ps(
+            _mm256_mul_ps(paperDist, _mm256_cvtepi32_ps(planeZ)), oriZ);
+        dz = blendFloat(dz, _mm256_add_ps(dz, lightDelta), isLight);
+        const __m256 t = blendFloat(
+            _mm256_set1_ps(-1), _mm256_div_ps(dz, dirZ), validPlane);
+
+        const __m256 x = _mm256_add_ps(oriX, _mm256_mul_ps(t, dirX));
+        const __m256 y = _mm256_add_ps(oriY, _mm256_mul_ps(t, dirY));
+        const __m256 z = _mm256_add_ps(oriZ, _mm256_mul_ps(t, dirZ));
+
+        hitX = blendFloat(hitX, x, active);
+        hitY = blendFloat(hitY, y, active);
+        hitZ = blendFloat(hitZ, z, active);
+
+        const __m256i escaped = _mm256_and_si256(
+            active, asInt(_mm256_cmp_ps(t, eps, _CMP_LE_OQ)));
+        __m256i rest = _mm256_andnot_si256(escaped, active);
+
+        const __m256i outside = asInt(_mm256_or_ps(
+            _mm256_or_ps(
+                _mm256_cmp_ps(x, zero, _CMP_LT_OQ),
+                _mm256_cmp_ps(y, zero, _CMP_LT_OQ)),
+            _mm256_or_ps(
+                _mm256_cmp_ps(x, outputW, _CMP_GT_OQ),
+                _mm256_cmp_ps(y, outputH, _CMP_GT_OQ))));
+        const __m256i oob = _mm256_and_si256(rest, outside);
+        rest = _mm256_andnot_si256(oob, rest);
+
+        __m256i px = _mm256_cvttps_epi32(
+            _mm256_mul_ps(_mm256_div_ps(x, outputW), paperWf));
+        __m256i py = _mm256_cvttps_epi32(
+            _mm256_mul_ps(_mm256_div_ps(y, outputH), paperHf));
+        px = _mm256_min_epi32(_mm256_max_epi32(px, izero), paperWm1);
+        py = _mm256_min_epi32(_mm256_max_epi32(py, izero), paperHm1);
+
+        hitPX = blendInt(hitPX, px, rest);
+        hitPY = blendInt(hitPY, py, rest);
+
+        const __m256i light = _mm256_and_si256(rest, isLight);
+        rest = _mm256_andnot_si256(light, rest);
+
+        // texels of fully solid pyramid tiles are not read
+
+        __m256i solidTile = izero;
+        if(stack.pyramid)
+        {
+            const PaperColumns &tiles = stack.pyramid->getSolidTileColumns();
+            const __m128i tileShift =
+                _mm_cvtsi32_si128(stack.pyramid->getTileShift(0));
+
+            const __m256i tileHalf = _mm256_add_epi32(
+                _mm256_mullo_epi32(
+                    _mm256_add_epi32(
+                        _mm256_mullo_epi32(
+                            _mm256_srl_epi32(py, tileShift),
+                            _mm256_set1_epi32(tiles.getWidth())),
+                        _mm256_srl_epi32(px, tileShift)),
+                    _mm256_set1_epi32(2 * tiles.getWordsPerColumn())),
+                _mm256_srli_epi32(planeZ, 5));
+            const __m256i tileWord = _mm256_mask_i32gather_epi32(
+                izero, reinterpret_cast<const int *>(tiles.getData()),
+                tileHalf, rest, 4);
+
+            const __m256i tileBit = _mm256_and_si256(
+                _mm256_srlv_epi32(tileWord, _mm256_and_si256(planeZ, bitMask)),
+                ione);
+            solidTile = _mm256_andnot_si256(
+                _mm256_cmpeq_epi32(tileBit, izero), rest);
+        }
+        const __m256i texel = _mm256_andnot_si256(solidTile, rest);
+
+        const __m256i halfIndex = _mm256_add_epi32(
+            _mm256_mullo_epi32(
+                _mm256_add_epi32(_mm256_mullo_epi32(planeZ, paperH), py),
+                rowHalves),
+            _mm256_srli_epi32(px, 5));
+        const __m256i halfWord = _mm256_mask_i32gather_epi32(
+            izero, reinterpret_cast<const int *>(stack.occupancy),
+            halfIndex, texel, 4);
+        const __m256i passableLayer = _mm256_mask_i32gather_epi32(
+            izero, stack.layerPassable, planeZ, texel, 4);
+
+        const __m256i bit = _mm256_and_si256(
+            _mm256_srlv_epi32(halfWord, _mm256_and_si256(px, bitMask)), ione);
+        const __m256i hollow = _mm256_or_si256(
+            _mm256_cmpeq_epi32(bit, izero),
+            _mm256_xor_si256(
+                _mm256_cmpeq_epi32(passableLayer, izero), minusOne));
+        const __m256i solid =
+            _mm256_or_si256(solidTile, _mm256_andnot_si256(hollow, texel));
+        const __m256i skip  = _mm256_and_si256(hollow, texel);
+        __m256i single = skip;
+
+        // skip runs of hollow planes within texel columns or pyramid tiles
+
+        if(columnLevelCount > 0 && !_mm256_testz_si256(skip, skip))
+        {
+            const __m256 u = _mm256_mul_ps(_mm256_div_ps(x, outputW), paperWf);
+            const __m256 v = _mm256_mul_ps(_mm256_div_ps(y, outputH), paperHf);
+
+            __m256i bestSkipCount = ione;
+            __m256i bestCellShift = izero;
+
+            __m256i pending = skip;
+            for(int level = 0; level < columnLevelCount; ++level)
+            {
+                if(_mm256_testz_si256(pending, pending))
+                    break;
+
+                int cellShift;
+                const PaperColumns *columns =
+                    getColumnLevel(stack, level, &cellShift);
+                if(!columns)
+                    continue;
+
+                // the ray leaves cells smaller than its step at the next plane
+                const __m256 cellSize = _mm256_set1_ps(float(1 << cellShift));
+                const __m256i candidates = _mm256_and_si256(
+                    pending,
+                    asInt(_mm256_cmp_ps(maxStep, cellSize, _CMP_LT_OQ)));
+                if(_mm256_testz_si256(candidates, candidates))
+                    continue;
+
+                const __m128i shiftCount = _mm_cvtsi32_si128(cellShift);
+                const __m256i cellX = _mm256_srl_epi32(px, shiftCount);
+                const __m256i cellY = _mm256_srl_epi32(py, shiftCount);
+
+                const __m256i runCount = countHollowPlanes(
+                    stack, *columns, candidates, forward,
+                    cellX, cellY, planeZ, stepZ);
+
+                // coarser cells can not contain longer hollow runs
+                const __m256i improvable = _mm256_and_si256(
+                    candidates, _mm256_cmpgt_epi32(runCount, bestSkipCount));
+                pending = _mm256_or_si256(
+                    _mm256_andnot_si256(candidates, pending), improvable);
+                if(_mm256_testz_si256(improvable, improvable))
+                    continue;
+
+                // number of following planes at which the ray stays in the cell
+
+                const __m256 cellU = _mm256_cvtepi32_ps(
+                    _mm256_sll_epi32(cellX, shiftCount));
+                const __m256 cellV = _mm256_cvtepi32_ps(
+                    _mm256_sll_epi32(cellY, shiftCount));
+
+                const __m256 distU = blendFloat(
+                    _mm256_sub_ps(u, cellU),
+                    _mm256_sub_ps(_mm256_add_ps(cellU, cellSize), u),
+                    uForward);
+                const __m256 distV = blendFloat(
+                    _mm256_sub_ps(v, cellV),
+                    _mm256_sub_ps(_mm256_add_ps(cellV, cellSize), v),
+                    vForward);
+
+                const __m256 stayCount = _mm256_min_ps(
+                    _mm256_min_ps(
+                        _mm256_div_ps(distU, absDu),
+                        _mm256_div_ps(distV, absDv)),
+                    _mm256_cvtepi32_ps(_mm256_sub_epi32(runCount, ione)));
+                const __m256i skipCount = _mm256_add_epi32(
+                    ione, _mm256_cvttps_epi32(stayCount));
+
+                const __m256i better = _mm256_and_si256(
+                    improvable, _mm256_cmpgt_epi32(skipCount, bestSkipCount));
+                bestSkipCount = blendInt(bestSkipCount, skipCount, better);
+                bestCellShift = blendInt(
+                    bestCellShift, _mm256_set1_epi32(cellShift), better);
+            }
+
+            const __m256i multi = _mm256_and_si256(
+                skip, _mm256_cmpgt_epi32(bestSkipCount, ione));
+            if(!_mm256_testz_si256(multi, multi))
+            {
+                const __m256i lastZ = _mm256_add_epi32(
+                    planeZ,
+                    _mm256_mullo_epi32(
+                        _mm256_sub_epi32(bestSkipCount, ione), stepZ));
+                const __m256 driftZ = _mm256_add_ps(z, _mm256_mul_ps(
+                    _mm256_cvtepi32_ps(_mm256_sub_epi32(bestSkipCount, ione)),
+                    stepEps));
+                const __m256 lastT = _mm256_div_ps(
+                    _mm256_sub_ps(
+                        _mm256_mul_ps(paperDist, _mm256_cvtepi32_ps(lastZ)),
+                        driftZ),
+                    dirZ);
+
+                const __m256 lx = _mm256_add_ps(x, _mm256_mul_ps(lastT, dirX));
+                const __m256 ly = _mm256_add_ps(y, _mm256_mul_ps(lastT, dirY));
+                const __m256 lz = _mm256_add_ps(
+                    driftZ, _mm256_mul_ps(lastT, dirZ));
+
+                const __m256i lastOob = asInt(_mm256_or_ps(
+                    _mm256_or_ps(
+                        _mm256_cmp_ps(lx, zero, _CMP_LT_OQ),
+                        _mm256_cmp_ps(ly, zero, _CMP_LT_OQ)),
+                    _mm256_or_ps(
+                        _mm256_cmp_ps(lx, outputW, _CMP_GT_OQ),
+                        _mm256_cmp_ps(ly, outputH, _CMP_GT_OQ))));
+
+                __m256i lpx = _mm256_cvttps_epi32(
+                    _mm256_mul_ps(_mm256_div_ps(lx, outputW), paperWf));
+                __m256i lpy = _mm256_cvttps_epi32(
+                    _mm256_mul_ps(_mm256_div_ps(ly, outputH), paperHf));
+                lpx = _mm256_min_epi32(_mm256_max_epi32(lpx, izero), paperWm1);
+                lpy = _mm256_min_epi32(_mm256_max_epi32(lpy, izero), paperHm1);
+
+                // cells are convex, so the ray stays in the cell at all
+                // planes in between
+                const __m256i sameCell = _mm256_and_si256(
+                    _mm256_cmpeq_epi32(
+                        _mm256_srlv_epi32(lpx, bestCellShift),
+                        _mm256_srlv_epi32(px, bestCellShift)),
+                    _mm256_cmpeq_epi32(
+                        _mm256_srlv_epi32(lpy, bestCellShift),
+                        _mm256_srlv_epi32(py, bestCellShift)));
+                const __m256i jump = _mm256_andnot_si256(
+                    lastOob, _mm256_and_si256(multi, sameCell));
+
+                oriX   = blendFloat(oriX, lx, jump);
+                oriY   = blendFloat(oriY, ly, jump);
+                oriZ   = blendFloat(oriZ, _mm256_add_ps(lz, stepEps), jump);
+                planeZ = blendInt(
+                    planeZ, _mm256_add_epi32(lastZ, stepZ), jump);
+
+                single = _mm256_andnot_si256(jump, single);
+            }
+        }
+
+        events = blendInt(
+            events, _mm256_set1_epi32(int32_t(TraversalEvent::Escaped)),
+            escaped);
+        events = blendInt(
+            events, _mm256_set1_epi32(int32_t(TraversalEvent::OutOfBounds)),
+            oob);
+        events = blendInt(
+            events, _mm256_set1_epi32(int32_t(TraversalEvent::BackLight)),
+            light);
+        events = blendInt(
+            events, _mm256_set1_epi32(int32_t(TraversalEvent::Paper)),
+            solid);
+
+        oriX   = blendFloat(oriX, x, single);
+        oriY   = blendFloat(oriY, y, single);
+        oriZ   = blendFloat(oriZ, _mm256_add_ps(z, stepEps), single);
+        planeZ = _mm256_add_epi32(planeZ, _mm256_and_si256(stepZ, single));
+
+        active = skip;
+    }
+
+    auto storeInt = [](void *p, __m256i v)
+    {
+        _mm256_store_si256(static_cast<__m256i *>(p), v);
+    };
+
+    _mm256_store_ps(packet.oriX, oriX);
+    _mm256_store_ps(packet.oriY, oriY);
+    _mm256_store_ps(packet.oriZ, oriZ);
+    storeInt(packet.planeZ, planeZ);
+    storeInt(packet.depth, depth);
+
+    _mm256_store_ps(hits.inctX, hitX);
+    _mm256_store_ps(hits.inctY, hitY);
+    _mm256_store_ps(hits.inctZ, hitZ);
+    storeInt(hits.paperX, hitPX);
+    storeInt(hits.paperY, hitPY);
+    storeInt(hits.event, events);
+}
+
+#else
+
+void traversePacket(
+    const PaperStackView &stack,
+    RayPacket            &packet,
+    uint32_t              activeMask,
+    TraversalHits        &hits) noexcept
+{
+    traversePacketScalar(stack, packet, activeMask, hits);
+}
+
+#endif
+
+PCL_END
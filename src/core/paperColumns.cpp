@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include <pcl/core/paperColumns.h>
+
+PCL_BEGIN
+
+PaperColumns::PaperColumns() noexcept
+    : width_(0), height_(0), layerCount_(0), wordsPerColumn_(0)
+{
+
+}
+
+void PaperColumns::resize(int width, int height, int layerCount)
+{
+    width_          = width;
+    height_         = height;
+    layerCount_     = layerCount;
+    wordsPerColumn_ = (layerCount + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    words_.assign(size_t(wordsPerColumn_) * width_ * height_, 0);
+}
+
+void PaperColumns::setLayer(int z, const OccupancyPlanes &occupancy) noexcept
+{
+    assert(occupancy.getWidth() == width_ && occupancy.getHeight() == height_);
+
+    const int      wordOffset = z >> 6;
+    const uint64_t layerBit   = uint64_t(1) << (z & 63);
+
+    for(int y = 0; y < height_; ++y)
+    {
+        const uint64_t *row = occupancy.getRow(y, z);
+        uint64_t *dst = &words_[size_t(y) * width_ * wordsPerColumn_];
+
+        for(int x = 0; x < width_; ++x)
+        {
+            uint64_t &word = dst[size_t(x) * wordsPerColumn_ + wordOffset];
+            if((row[x >> 6] >> (x & 63)) & 1)
+                word |= layerBit;
+            else
+                word &= ~layerBit;
+        }
+    }
+}
+
+void PaperColumns::clearLayer(int z) noexcept
+{
+    const int      wordOffset = z >> 6;
+    const uint64_t layerMask  = ~(uint64_t(1) << (z & 63));
+
+    const size_t columnCount = size_t(width_) * height_;
+    for(size_t i = 0; i < columnCount; ++i)
+        words_[i * wordsPerColumn_ + wordOffset] &= layerMask;
+}
+
+PCL_END
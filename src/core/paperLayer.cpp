@@ -0,0 +1,30 @@
+#include <pcl/core/paperLayer.h>
+
+PCL_BEGIN
+
+Image2D<uint8_t> rgbToLayerBinary(const Image2D<agz::math::color3b> &rgb)
+{
+    return Image2D<uint8_t>(rgb.map([](const agz::math::color3b &c)
+    {
+        return static_cast<uint8_t>((c.r || c.g || c.b) ? 255 : 0);
+    }));
+}
+
+Image2D<PaperTexel> binaryToTracerTexels(const Image2D<uint8_t> &tex)
+{
+    Image2D<PaperTexel> data(tex.height(), tex.width());
+    for(int y = 0; y < data.height(); ++y)
+    {
+        for(int x = 0; x < data.width(); ++x)
+        {
+            auto &d = data(y, x);
+            d.r = 255;
+            d.g = 255;
+            d.b = 255;
+            d.binary = tex(y, x) > 0 ? 255 : 0;
+        }
+    }
+    return data;
+}
+
+PCL_END
@@ -0,0 +1,55 @@
+#include <algorithm>
+
+#include <pcl/core/pathStatistics.h>
+
+PCL_BEGIN
+
+void PathStatistics::clear() noexcept
+{
+    pathCount      = 0;
+    iterationCount = 0;
+    scatterCount   = 0;
+    std::fill(std::begin(terminations), std::end(terminations), uint64_t(0));
+    std::fill(
+        scatterDepthHistogram.begin(), scatterDepthHistogram.end(), uint64_t(0));
+}
+
+void PathStatistics::merge(const PathStatistics &rhs)
+{
+    pathCount      += rhs.pathCount;
+    iterationCount += rhs.iterationCount;
+    scatterCount   += rhs.scatterCount;
+
+    for(int i = 0; i < static_cast<int>(PathTermination::Count); ++i)
+        terminations[i] += rhs.terminations[i];
+
+    if(scatterDepthHistogram.size() < rhs.scatterDepthHistogram.size())
+        scatterDepthHistogram.resize(rhs.scatterDepthHistogram.size(), 0);
+    for(size_t i = 0; i < rhs.scatterDepthHistogram.size(); ++i)
+        scatterDepthHistogram[i] += rhs.scatterDepthHistogram[i];
+}
+
+void PathStatistics::addPath(
+    PathTermination termination, int iterations, int scatterDepth)
+{
+    ++pathCount;
+    iterationCount += iterations;
+    scatterCount   += scatterDepth;
+    ++terminations[static_cast<int>(termination)];
+
+    if(scatterDepthHistogram.size() <= size_t(scatterDepth))
+        scatterDepthHistogram.resize(scatterDepth + 1, 0);
+    ++scatterDepthHistogram[scatterDepth];
+}
+
+double PathStatistics::getMeanIterationCount() const noexcept
+{
+    return pathCount ? double(iterationCount) / pathCount : 0.0;
+}
+
+double PathStatistics::getMeanScatterDepth() const noexcept
+{
+    return pathCount ? double(scatterCount) / pathCount : 0.0;
+}
+
+PCL_END
@@ -0,0 +1,138 @@
+#include <cstring>
+
+#include <pcl/core/scene.h>
+
+PCL_BEGIN
+
+uint64_t hashJensenParams(const JensenParams &params) noexcept
+{
+    const float fields[] = {
+        params.gf, params.gb, params.wf,
+        params.frontEta, params.backEta,
+        params.frontM, params.backM,
+        params.d, params.sigmaS, params.sigmaA,
+        params.diffusionAlbedo.x,
+        params.diffusionAlbedo.y,
+        params.diffusionAlbedo.z
+    };
+
+    uint64_t hash = 0xcbf29ce484222325;
+    for(float f : fields)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        for(int i = 0; i < 4; ++i)
+        {
+            hash ^= (bits >> (8 * i)) & 0xff;
+            hash *= 0x100000001b3;
+        }
+    }
+    return hash;
+}
+
+float SceneParams::getTracerPaperDistance(int paperTexelWidth) const noexcept
+{
+    return paperDistance * paperTexelWidth / paperWidth;
+}
+
+float SceneParams::getTracerBackLightDistance(
+    int paperTexelWidth) const noexcept
+{
+    return backLightDistance * paperTexelWidth / paperWidth;
+}
+
+Float3 SceneParams::getLinearEnvLight() const noexcept
+{
+    return envLight.map([](float v)
+    {
+        return std::pow(v, 2.2f);
+    });
+}
+
+float SceneParams::getEyeZ() const noexcept
+{
+    return perspectiveCamera ? -(5 - perspectiveCameraZ) : 1;
+}
+
+const JensenParams &Scene::getLayerMaterial(int z) const noexcept
+{
+    if(static_cast<size_t>(z) < layerMaterials.size())
+        return layerMaterials[z];
+    return params.jensenParams;
+}
+
+void setPaperJensen(
+    RenderBackend &backend, int z, const JensenParams &params)
+{
+    backend.setPaperJensen(
+        z,
+        params.gf, params.gb,
+        params.wf, 1 - params.wf,
+        params.frontEta, params.backEta,
+        params.frontM, params.backM,
+        params.d, params.sigmaS, params.sigmaA,
+        params.diffusionAlbedo);
+}
+
+Image2D<agz::math::color3f> computeBackLightRadiance(
+    const Image2D<agz::math::color3b> &light, float intensity)
+{
+    Image2D<agz::math::color3f> data(light.height(), light.width());
+    for(int y = 0; y < light.height(); ++y)
+    {
+        for(int x = 0; x < light.width(); ++x)
+        {
+            auto &t  = light(y, x);
+            auto &dt = data(y, x);
+            dt.r = intensity * std::pow(t.r / 255.0f, 2.2f);
+            dt.g = intensity * std::pow(t.g / 255.0f, 2.2f);
+            dt.b = intensity * std::pow(t.b / 255.0f, 2.2f);
+        }
+    }
+    return data;
+}
+
+void uploadScene(const Scene &scene, RenderBackend &backend)
+{
+    const Int2 &size = scene.paperSize;
+    const int layerCount = static_cast<int>(scene.layers.size());
+
+    backend.setPaperSize({ size.x, size.y, layerCount });
+
+    for(int z = 0; z < layerCount; ++z)
+    {
+        const auto &layer = scene.layers[z];
+        if(layer.is_available())
+        {
+            if(layer.size() != size)
+            {
+                throw PCLException(
+                    "unmatched size of layer " + std::to_string(z));
+            }
+            backend.setPaperData(z, binaryToTracerTexels(layer).raw_data());
+        }
+        else
+        {
+            Image2D<PaperTexel> data(size.y, size.x, { 0, 0, 0, 0 });
+            backend.setPaperData(z, data.raw_data());
+        }
+
+        setPaperJensen(backend, z, scene.getLayerMaterial(z));
+    }
+
+    if(scene.light.is_available())
+    {
+        if(scene.light.size() != size)
+            throw PCLException("unmatched size of light image");
+        backend.setBackLightRadiance(computeBackLightRadiance(
+            scene.light, scene.params.lightIntensity).raw_data());
+    }
+
+    backend.setPaperDistance(scene.params.getTracerPaperDistance(size.x));
+    backend.setBackLightDistance(
+        scene.params.getTracerBackLightDistance(size.x));
+    backend.setEnvLight(scene.params.getLinearEnvLight());
+    backend.setEyeZ(scene.params.getEyeZ());
+}
+
+PCL_END
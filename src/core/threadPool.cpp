@@ -0,0 +1,156 @@
+#include <pcl/core/threadPool.h>
+
+PCL_BEGIN
+
+ThreadPool::ThreadPool(int threadCount)
+    : func_(nullptr), generation_(0), pendingTasks_(0),
+      activeWorkers_(0), stop_(false)
+{
+    if(threadCount <= 0)
+    {
+        threadCount += static_cast<int>(std::thread::hardware_concurrency());
+        threadCount = (std::max)(threadCount, 1);
+    }
+    threadCount_ = threadCount;
+
+    for(int i = 0; i < threadCount_; ++i)
+        queues_.push_back(std::make_unique<TaskQueue>());
+
+    for(int i = 1; i < threadCount_; ++i)
+        workers_.emplace_back(&ThreadPool::workerMain, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lk(mutex_);
+        stop_ = true;
+    }
+    startCond_.notify_all();
+
+    for(auto &w : workers_)
+        w.join();
+}
+
+int ThreadPool::getThreadCount() const noexcept
+{
+    return threadCount_;
+}
+
+void ThreadPool::parallelFor(int taskCount, const Func &func)
+{
+    if(taskCount <= 0)
+        return;
+
+    if(threadCount_ == 1)
+    {
+        for(int i = 0; i < taskCount; ++i)
+            func(0, i);
+        return;
+    }
+
+    {
+        std::lock_guard lk(mutex_);
+        func_         = &func;
+        pendingTasks_ = taskCount;
+    }
+
+    for(int i = 0; i < threadCount_; ++i)
+    {
+        const int beg = static_cast<int>(
+            int64_t(taskCount) * i / threadCount_);
+        const int end = static_cast<int>(
+            int64_t(taskCount) * (i + 1) / threadCount_);
+
+        auto &queue = *queues_[i];
+        std::lock_guard lk(queue.mutex);
+        for(int t = beg; t < end; ++t)
+            queue.tasks.push_back(t);
+    }
+
+    {
+        std::lock_guard lk(mutex_);
+        ++generation_;
+    }
+    startCond_.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock lk(mutex_);
+    doneCond_.wait(lk, [&]
+    {
+        return pendingTasks_ == 0 && activeWorkers_ == 0;
+    });
+    func_ = nullptr;
+}
+
+bool ThreadPool::popTask(int threadIndex, int *task)
+{
+    {
+        auto &own = *queues_[threadIndex];
+        std::lock_guard lk(own.mutex);
+        if(!own.tasks.empty())
+        {
+            *task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for(int i = 1; i < threadCount_; ++i)
+    {
+        auto &victim = *queues_[(threadIndex + i) % threadCount_];
+        std::lock_guard lk(victim.mutex);
+        if(!victim.tasks.empty())
+        {
+            *task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runTasks(int threadIndex)
+{
+    int task;
+    while(popTask(threadIndex, &task))
+    {
+        (*func_)(threadIndex, task);
+
+        std::lock_guard lk(mutex_);
+        if(--pendingTasks_ == 0)
+            doneCond_.notify_all();
+    }
+}
+
+void ThreadPool::workerMain(int threadIndex)
+{
+    uint64_t seenGeneration = 0;
+
+    for(;;)
+    {
+        {
+            std::unique_lock lk(mutex_);
+            startCond_.wait(lk, [&]
+            {
+                return stop_ || generation_ != seenGeneration;
+            });
+
+            if(stop_)
+                return;
+
+            seenGeneration = generation_;
+            ++activeWorkers_;
+        }
+
+        runTasks(threadIndex);
+
+        std::lock_guard lk(mutex_);
+        if(--activeWorkers_ == 0 && pendingTasks_ == 0)
+            doneCond_.notify_all();
+    }
+}
+
+PCL_END
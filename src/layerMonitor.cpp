@@ -1,5 +1,6 @@
 #include <agz-utils/image.h>
 
+#include <pcl/core/paperLayer.h>
 #include <pcl/layerMonitor.h>
 
 PCL_BEGIN
@@ -137,11 +138,7 @@ void LayerMonitor::reloadLayer(LayerID id)
     try
     {
         auto newData = agz::img::load_rgb_from_file(path.string());
-        it2->second.paper = Image2D<uint8_t>(newData.map(
-            [](const agz::math::color3b &c)
-        {
-            return static_cast<uint8_t>((c.r || c.g || c.b) ? 255 : 0);
-        }));
+        it2->second.paper = rgbToLayerBinary(newData);
     }
     catch(...)
     {
@@ -51,22 +51,19 @@ namespace
         ImGui::SetCursorPos(backupPos);
     }
 
-    Image2D<Tracer::Texel> binaryToTracerTexels(const Image2D<uint8_t> &tex)
-    {
-        Image2D<Tracer::Texel> data(tex.height(), tex.width());
-        for(int y = 0; y < data.height(); ++y)
-        {
-            for(int x = 0; x < data.width(); ++x)
-            {
-                auto &d = data(y, x);
-                d.r = 255;
-                d.g = 255;
-                d.b = 255;
-                d.binary = tex(y, x) > 0 ? 255 : 0;
-            }
-        }
-        return data;
-    }
+    // frames of every pixel before its noise is tested
+    constexpr int ADAPTIVE_MIN_FRAMES = 16;
+
+    // weight of the latest frame in the moving average of frame time
+    constexpr float FRAME_TIME_SMOOTHING = 0.05f;
+
+    // preview ladder after a scene change: 1/4 resolution until input has
+    // been idle for PREVIEW_HALF_DELAY seconds, then 1/2 resolution until
+    // PREVIEW_FULL_DELAY, then full resolution accumulation
+    constexpr float PREVIEW_HALF_DELAY = 0.1f;
+    constexpr float PREVIEW_FULL_DELAY = 0.3f;
+
+    constexpr int PREVIEW_MAX_SCATTER_DEPTH = 3;
 
     void showTip(const std::string &text)
     {
@@ -90,23 +87,18 @@ PCL::PCL(const Int2 &paperSize)
 
     paperSize_ = paperSize;
 
-    paperDistance_ = 10;
-    paperWidth_    = 200;
-
-    backLightDistance_  = 1;
-
     spp_           = 1;
     maxAccuFrames_ = 1024;
 
-    perspectiveCamera_ = false;
-    perspectiveCameraZ_ = 1;
-    exposure_ = 1;
+    errorThreshold_ = 0.01f;
+    frameSeconds_   = 0;
+
+    isPreviewing_ = false;
 
-    envLight_ = { 0, 0, 0 };
+    exposure_ = 1;
 
     lightStatus_ = PaperRecord::Status::Nil;
     lightLayer_  = 0;
-    lightIntensity_ = 1;
 
     selectedPaperIdx_ = 0;
 
@@ -114,16 +106,19 @@ PCL::PCL(const Int2 &paperSize)
     tracer_  = std::make_unique<Tracer>(
         paperSize,
         Int3(paperSize.x, paperSize.y, 1),
-        paperDistance_ * paperSize_.x / paperWidth_,
+        sceneParams_.getTracerPaperDistance(paperSize_.x),
         spp_);
     accumulator_ = std::make_unique<Accumulator>(paperSize_.x, paperSize_.y);
     toneMapper_ = std::make_unique<ToneMapper>(paperSize_.x, paperSize_.y);
 
+    updateAdaptiveSampling();
+    tracer_->setConvergedMask(accumulator_->getConvergedMask());
+
     monitor_->attach<LayerModification>(this);
     monitor_->attach<LightModification>(this);
 
-    tracer_->setEnvLight(envLight_);
-    tracer_->setEyeZ(perspectiveCamera_ ? -perspectiveCameraZ_ : 1);
+    tracer_->setEnvLight(sceneParams_.getLinearEnvLight());
+    tracer_->setEyeZ(sceneParams_.getEyeZ());
 
     toneMapper_->setExposure(exposure_);
 
@@ -169,7 +164,8 @@ void PCL::display(const d3d11::Window &window)
 
 bool PCL::isAccumulating() const noexcept
 {
-    return accumulator_->getAccumulatedFrameCount() < maxAccuFrames_;
+    return accumulator_->getAccumulatedFrameCount() < maxAccuFrames_ &&
+           !accumulator_->isConverged();
 }
 
 void PCL::showStatusText(PaperRecord::Status status) const
@@ -197,7 +193,7 @@ void PCL::updatePaperBinary(size_t paperIndex)
     }
     else
     {
-        Image2D<Tracer::Texel> data(paperSize_.y, paperSize_.x, { 0, 0, 0, 0 });
+        Image2D<PaperTexel> data(paperSize_.y, paperSize_.x, { 0, 0, 0, 0 });
         tracer_->setPaperData(
             static_cast<int>(paperIndex), data.raw_data());
     }
@@ -205,18 +201,23 @@ void PCL::updatePaperBinary(size_t paperIndex)
 
 void PCL::updateMaterial()
 {
-    for(size_t i = 0; i < papers_.size(); ++i)
-    {
-        tracer_->setPaperJensen(
-            static_cast<int>(i),
-            jensenParams_.gf, jensenParams_.gb,
-            jensenParams_.wf, 1 - jensenParams_.wf,
-            jensenParams_.frontEta, jensenParams_.backEta,
-            jensenParams_.frontM, jensenParams_.backM,
-            jensenParams_.d, jensenParams_.sigmaS, jensenParams_.sigmaA,
-            jensenParams_.diffusionAlbedo);
-    }
-    accumulator_->clearHistory();
+    std::vector<JensenParams> materials;
+    materials.reserve(papers_.size());
+    for(auto &paper : papers_)
+        materials.push_back(paper.material);
+
+    if(layerMaterials_.update(*tracer_, materials))
+        restartAccumulation();
+}
+
+void PCL::resizeTracerPapers()
+{
+    tracer_->setPaperSize({
+        paperSize_.x,
+        paperSize_.y,
+        static_cast<int>(papers_.size())
+    });
+    layerMaterials_.invalidate();
 }
 
 void PCL::displaySettingPanel()
@@ -337,7 +338,8 @@ void PCL::displaySettingPanel()
                         layer2PaperIdx_[p.layerID] = i;
                     updatePaperBinary(i);
                 }
-                accumulator_->clearHistory();
+                updateMaterial();
+                restartAccumulation();
             }
             ImGui::EndDragDropTarget();
         }
@@ -422,55 +424,59 @@ void PCL::displaySettingPanel()
         setLightFilename(filename.u8string());
     }
 
-    if(ImGui::SliderFloat(PCL_LANG_LIGHT_INTENSITY, &lightIntensity_, 0, 40))
+    if(ImGui::SliderFloat(
+        PCL_LANG_LIGHT_INTENSITY, &sceneParams_.lightIntensity, 0, 40))
         handle(LightModification{});
 
-    if(ImGui::ColorEdit3(PCL_LANG_ENV_LIGHT, &envLight_.x))
+    if(ImGui::ColorEdit3(PCL_LANG_ENV_LIGHT, &sceneParams_.envLight.x))
     {
-        tracer_->setEnvLight(envLight_.map([](float v)
-        {
-            return std::pow(v, 2.2f);
-        }));
-        accumulator_->clearHistory();
+        tracer_->setEnvLight(sceneParams_.getLinearEnvLight());
+        restartAccumulation();
     }
 
-    if(ImGui::SliderFloat(PCL_LANG_LIGHT_DISTANCE, &backLightDistance_, 1, 100))
+    if(ImGui::SliderFloat(
+        PCL_LANG_LIGHT_DISTANCE, &sceneParams_.backLightDistance, 1, 100))
     {
         tracer_->setBackLightDistance(
-            backLightDistance_ * paperSize_.x / paperWidth_);
-        accumulator_->clearHistory();
+            sceneParams_.getTracerBackLightDistance(paperSize_.x));
+        restartAccumulation();
     }
 
     // global
 
-    if(ImGui::InputFloat(PCL_LANG_PAPER_HORI_SIZE, &paperWidth_, 1, 10))
+    if(ImGui::InputFloat(
+        PCL_LANG_PAPER_HORI_SIZE, &sceneParams_.paperWidth, 1, 10))
     {
-        paperWidth_ = (std::max)(paperWidth_, 10.0f);
+        sceneParams_.paperWidth = (std::max)(sceneParams_.paperWidth, 10.0f);
         tracer_->setPaperDistance(
-            paperDistance_ * paperSize_.x / paperWidth_);
+            sceneParams_.getTracerPaperDistance(paperSize_.x));
         tracer_->setBackLightDistance(
-            backLightDistance_ *paperSize_.x / paperWidth_);
-        accumulator_->clearHistory();
+            sceneParams_.getTracerBackLightDistance(paperSize_.x));
+        restartAccumulation();
     }
 
-    if(ImGui::SliderFloat(PCL_LANG_PAPER_DISTANCE, &paperDistance_, 1, 100))
+    if(ImGui::SliderFloat(
+        PCL_LANG_PAPER_DISTANCE, &sceneParams_.paperDistance, 1, 100))
     {
-        tracer_->setPaperDistance(paperDistance_ * paperSize_.x / paperWidth_);
-        accumulator_->clearHistory();
+        tracer_->setPaperDistance(
+            sceneParams_.getTracerPaperDistance(paperSize_.x));
+        restartAccumulation();
     }
 
-    if(ImGui::Checkbox(PCL_LANG_USE_PERSPECTIVE, &perspectiveCamera_))
+    if(ImGui::Checkbox(
+        PCL_LANG_USE_PERSPECTIVE, &sceneParams_.perspectiveCamera))
     {
-        tracer_->setEyeZ(perspectiveCamera_ ? -(5 - perspectiveCameraZ_) : 1);
-        accumulator_->clearHistory();
+        tracer_->setEyeZ(sceneParams_.getEyeZ());
+        restartAccumulation();
     }
 
-    if(perspectiveCamera_ &&
+    if(sceneParams_.perspectiveCamera &&
        ImGui::SliderFloat(
-           PCL_LANG_PERSPECTIVE_DISTANCE, &perspectiveCameraZ_, 0, 4.9f))
+           PCL_LANG_PERSPECTIVE_DISTANCE,
+           &sceneParams_.perspectiveCameraZ, 0, 4.9f))
     {
-        tracer_->setEyeZ(-(5 - perspectiveCameraZ_));
-        accumulator_->clearHistory();
+        tracer_->setEyeZ(sceneParams_.getEyeZ());
+        restartAccumulation();
     }
 
     if(ImGui::SliderFloat(PCL_LANG_EXPOSURE, &exposure_, 0, 5))
@@ -481,31 +487,43 @@ void PCL::displaySettingPanel()
 
     // material
 
-    if(ImGui::TreeNode(PCL_LANG_MATERIAL))
+    if(!papers_.empty() && ImGui::TreeNode(PCL_LANG_MATERIAL))
     {
+        auto &jensen = papers_[selectedPaperIdx_].material;
+
+        ImGui::TextUnformatted(papers_[selectedPaperIdx_].name.c_str());
+
         bool materialChanged = false;
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_FRONT_G, &jensenParams_.gf, -1, 1);
+            PCL_LANG_FRONT_G, &jensen.gf, -1, 1);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_BACK_G, &jensenParams_.gb, -1, 1);
+            PCL_LANG_BACK_G, &jensen.gb, -1, 1);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_FRONT_G_WEIGHT, &jensenParams_.wf, 0, 1);
+            PCL_LANG_FRONT_G_WEIGHT, &jensen.wf, 0, 1);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_FRONT_IOR, &jensenParams_.frontEta, 1.01f, 3);
+            PCL_LANG_FRONT_IOR, &jensen.frontEta, 1.01f, 3);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_BACK_IOR, &jensenParams_.backEta, 1.01f, 3);
+            PCL_LANG_BACK_IOR, &jensen.backEta, 1.01f, 3);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_FRONT_ROUGH, &jensenParams_.frontM, 0, 1);
+            PCL_LANG_FRONT_ROUGH, &jensen.frontM, 0, 1);
         materialChanged |= ImGui::SliderFloat(
-            PCL_LANG_BACK_ROUGH, &jensenParams_.backM, 0, 1);
+            PCL_LANG_BACK_ROUGH, &jensen.backM, 0, 1);
         materialChanged |= ImGui::InputFloat(
-            PCL_LANG_PAPER_THICKNESS, &jensenParams_.d, 0.01f, 0.1f, 6);
+            PCL_LANG_PAPER_THICKNESS, &jensen.d, 0.01f, 0.1f, 6);
         materialChanged |= ImGui::InputFloat(
-            PCL_LANG_SIGMA_S, &jensenParams_.sigmaS, 1, 10, 6);
+            PCL_LANG_SIGMA_S, &jensen.sigmaS, 1, 10, 6);
         materialChanged |= ImGui::InputFloat(
-            PCL_LANG_SIGMA_A, &jensenParams_.sigmaA, 0.001f, 0.1f, 6);
+            PCL_LANG_SIGMA_A, &jensen.sigmaA, 0.001f, 0.1f, 6);
         materialChanged |= ImGui::ColorEdit3(
-            PCL_LANG_DIF_ALBEDO, &jensenParams_.diffusionAlbedo.x);
+            PCL_LANG_DIF_ALBEDO, &jensen.diffusionAlbedo.x);
+
+        if(ImGui::Button(PCL_LANG_APPLY_TO_ALL_LAYERS))
+        {
+            const JensenParams selected = jensen;
+            for(auto &paper : papers_)
+                paper.material = selected;
+            materialChanged = true;
+        }
 
         if(materialChanged)
             updateMaterial();
@@ -520,28 +538,104 @@ void PCL::displaySettingPanel()
         if(ImGui::SliderInt(PCL_LANG_GPU_PERFORMANCE, &spp_, 1, 8, ""))
         {
             tracer_->setSPP(spp_);
-            accumulator_->clearHistory();
+            restartAccumulation();
         }
         ImGui::SameLine();
         ImGui::Text("%d\n", spp_);
 
-        ImGui::SliderInt(PCL_LANG_RENDER_QUALITY, &maxAccuFrames_, 1, 4096, "");
+        if(ImGui::SliderInt(
+            PCL_LANG_RENDER_QUALITY, &maxAccuFrames_, 1, 4096, ""))
+            updateAdaptiveSampling();
         ImGui::SameLine();
         ImGui::Text("%d\n", maxAccuFrames_);
 
+        // converged pixels are never sampled again, so the history is
+        // restarted when the threshold changes
+
+        if(ImGui::SliderFloat(
+            PCL_LANG_NOISE_THRESHOLD, &errorThreshold_, 0, 0.1f, "%.3f"))
+        {
+            updateAdaptiveSampling();
+            restartAccumulation();
+        }
+        showTip(PCL_LANG_NOISE_THRESHOLD_TIPS);
+
+        const int pixelCount = accumulator_->getUnconvergedPixelCount();
+        const int frameCount = accumulator_->getAccumulatedFrameCount();
+
+        ImGui::Text(
+            PCL_LANG_RENDER_PROGRESS, frameCount,
+            100.0f * pixelCount / accumulator_->getPixelCount());
+
+        // frame time is roughly proportional to the number of traced pixels
+
+        if(isAccumulating() && frameSeconds_ > 0 && pixelCount > 0)
+        {
+            const double pixelFrames = (std::min)(
+                accumulator_->getRemainingPixelFrames(),
+                double(maxAccuFrames_ - frameCount) * pixelCount);
+            ImGui::Text(
+                PCL_LANG_REMAINING_TIME,
+                pixelFrames * frameSeconds_ / pixelCount);
+        }
+
         ImGui::TreePop();
     }
 }
 
 void PCL::displayRenderPanel()
 {
-    if(accumulator_->getAccumulatedFrameCount() < maxAccuFrames_)
+    const auto now = std::chrono::steady_clock::now();
+
+    const float idleSeconds =
+        std::chrono::duration<float>(now - lastEditTime_).count();
+    const int previewScale = idleSeconds < PREVIEW_HALF_DELAY ? 4 :
+                             idleSeconds < PREVIEW_FULL_DELAY ? 2 : 1;
+
+    if(previewScale > 1)
+    {
+        // preview frames are not accumulated
+
+        tracer_->setPreviewScale(previewScale);
+        tracer_->setMaxScatterDepth(PREVIEW_MAX_SCATTER_DEPTH);
+        tracer_->render();
+
+        accumulator_->clearHistory();
+        accumulator_->addNewFrame(tracer_->getOutput());
+        toneMapper_->render(accumulator_->getAccumulatedOutput());
+
+        isPreviewing_ = true;
+    }
+    else if(isPreviewing_)
+    {
+        tracer_->setPreviewScale(1);
+        tracer_->setMaxScatterDepth(Tracer::DEFAULT_MAX_SCATTER_DEPTH);
+        accumulator_->clearHistory();
+
+        isPreviewing_ = false;
+    }
+
+    if(!isPreviewing_ && isAccumulating())
     {
+        if(accumulator_->getAccumulatedFrameCount() > 0)
+        {
+            const float seconds =
+                std::chrono::duration<float>(now - lastFrameTime_).count();
+            if(frameSeconds_ > 0)
+                frameSeconds_ += FRAME_TIME_SMOOTHING * (seconds - frameSeconds_);
+            else
+                frameSeconds_ = seconds;
+        }
+        else
+            frameSeconds_ = 0;
+
         tracer_->render();
         accumulator_->addNewFrame(tracer_->getOutput());
         toneMapper_->render(accumulator_->getAccumulatedOutput());
     }
 
+    lastFrameTime_ = now;
+
     const auto [panelW, panelH] = ImGui::GetContentRegionAvail();
 
     ImVec2 size;
@@ -565,6 +659,18 @@ void PCL::displayRenderPanel()
     ImGui::Image(toneMapper_->getOutput().Get(), size);
 }
 
+void PCL::restartAccumulation()
+{
+    lastEditTime_ = std::chrono::steady_clock::now();
+    accumulator_->clearHistory();
+}
+
+void PCL::updateAdaptiveSampling()
+{
+    accumulator_->setAdaptiveSampling(
+        errorThreshold_, ADAPTIVE_MIN_FRAMES, maxAccuFrames_);
+}
+
 void PCL::handle(const LayerModification &event)
 {
     const auto &tex = monitor_->getLayer(event.id);
@@ -579,7 +685,7 @@ void PCL::handle(const LayerModification &event)
         rcd.status = PaperRecord::Status::Ok;
 
     updatePaperBinary(paperIdx);
-    accumulator_->clearHistory();
+    restartAccumulation();
 }
 
 void PCL::handle(const LightModification &event)
@@ -595,37 +701,28 @@ void PCL::handle(const LightModification &event)
 
     if(lightStatus_ == PaperRecord::Status::Ok)
     {
-        Image2D<agz::math::color3f> data(tex.height(), tex.width());
-        for(int y = 0; y < tex.height(); ++y)
-        {
-            for(int x = 0; x < tex.width(); ++x)
-            {
-                auto &t  = tex(y, x);
-                auto &dt = data(y, x);
-                dt.r = lightIntensity_ * std::pow(t.r / 255.0f, 2.2f);
-                dt.g = lightIntensity_ * std::pow(t.g / 255.0f, 2.2f);
-                dt.b = lightIntensity_ * std::pow(t.b / 255.0f, 2.2f);
-            }
-        }
+        const auto data = computeBackLightRadiance(
+            tex, sceneParams_.lightIntensity);
 
         tracer_->setBackLightRadiance(data.raw_data());
-        accumulator_->clearHistory();
+        restartAccumulation();
     }
 }
 
 void PCL::addNewPaper(const std::string &name)
 {
+    // new layers start with the material of the selected one
+    const JensenParams material = papers_.empty() ?
+        sceneParams_.jensenParams : papers_[selectedPaperIdx_].material;
+
     papers_.emplace_back();
     auto &rcd = papers_.back();
-    rcd.name    = findAvailName(name);
-    rcd.layerID = 0;
-    rcd.status  = PaperRecord::Status::Nil;
+    rcd.name     = findAvailName(name);
+    rcd.layerID  = 0;
+    rcd.status   = PaperRecord::Status::Nil;
+    rcd.material = material;
 
-    tracer_->setPaperSize({
-        paperSize_.x,
-        paperSize_.y,
-        static_cast<int>(papers_.size())
-    });
+    resizeTracerPapers();
 
     for(size_t i = 0; i < papers_.size(); ++i)
         updatePaperBinary(i);
@@ -711,11 +808,7 @@ void PCL::tryRemoveLayer(size_t idx)
     layer2PaperIdx_.erase(p.layerID);
     papers_.erase(papers_.begin() + idx);
 
-    tracer_->setPaperSize({
-        paperSize_.x,
-        paperSize_.y,
-        static_cast<int>(papers_.size())
-        });
+    resizeTracerPapers();
 
     if(selectedPaperIdx_ >= papers_.size())
         --selectedPaperIdx_;
@@ -728,6 +821,9 @@ void PCL::tryRemoveLayer(size_t idx)
 
 void PCL::loadAllLayers(const std::vector<std::filesystem::path> &all)
 {
+    const JensenParams material = papers_.empty() ?
+        sceneParams_.jensenParams : papers_[selectedPaperIdx_].material;
+
     for(auto &p : papers_)
     {
         if(p.status != PaperRecord::Status::Nil)
@@ -737,16 +833,13 @@ void PCL::loadAllLayers(const std::vector<std::filesystem::path> &all)
     layer2PaperIdx_.clear();
     selectedPaperIdx_ = 0;
 
-    tracer_->setPaperSize({
-        paperSize_.x,
-        paperSize_.y,
-        static_cast<int>(all.size())
-    });
-
     papers_.resize(all.size());
+    resizeTracerPapers();
+
     for(size_t i = 0; i < papers_.size(); ++i)
     {
-        papers_[i].name = findAvailName("");
+        papers_[i].name     = findAvailName("");
+        papers_[i].material = material;
         setPaperFilename(i, all[i].u8string());
     }
 
@@ -770,12 +863,10 @@ void PCL::setPaperSize(int width, int height)
     paperSize_.x = width;
     paperSize_.y = height;
 
-    tracer_->setPaperSize(
-        {
-            width, height, static_cast<int>(papers_.size())
-        });
+    resizeTracerPapers();
     tracer_->setOutputSize(oSize);
     accumulator_->setSize(oSize.x, oSize.y);
+    tracer_->setConvergedMask(accumulator_->getConvergedMask());
     toneMapper_->setSize(oSize.x, oSize.y);
 
     for(auto &p : papers_)
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <pcl/renderer/accumulator.h>
 
 PCL_BEGIN
@@ -5,14 +7,21 @@ PCL_BEGIN
 Accumulator::Accumulator(int width, int height)
     : width_(static_cast<UINT>(width)),
       height_(static_cast<UINT>(height)),
-      historySlot_(nullptr),
+      errorThreshold_(0), minFrameCount_(2), maxFrameCount_(1024),
       newFrameSlot_(nullptr),
-      outputSlot_(nullptr),
+      isMeanResolved_(false),
+      statisticsPending_(false),
+      discardPendingStatistics_(false),
+      unconvergedPixelCount_(width * height),
+      remainingPixelFrames_(0),
       accumulatedCount_(0)
 {
     initShader();
-    initPingPongTextures();
+    initAccumulationTextures();
+    initConvergedMask();
+    initStatisticsBuffers();
     initPerFrameConsts();
+    clearHistory();
 }
 
 void Accumulator::setSize(int width, int height)
@@ -20,30 +29,45 @@ void Accumulator::setSize(int width, int height)
     width_  = width;
     height_ = height;
 
-    initPingPongTextures();
+    initAccumulationTextures();
+    initConvergedMask();
     clearHistory();
 }
 
+void Accumulator::setAdaptiveSampling(
+    float errorThreshold, int minFrameCount, int maxFrameCount) noexcept
+{
+    errorThreshold_ = errorThreshold;
+    minFrameCount_  = (std::max)(minFrameCount, 2);
+    maxFrameCount_  = maxFrameCount;
+}
+
 void Accumulator::clearHistory()
 {
-    accumulatedCount_ = 0;
+    const UINT zeros[4] = { 0, 0, 0, 0 };
+    d3d11::deviceContext->ClearUnorderedAccessViewUint(
+        converged_.uav.Get(), zeros);
+
+    const float floatZeros[4] = { 0, 0, 0, 0 };
+    for(auto buffer : { &sum_, &moments_ })
+    {
+        d3d11::deviceContext->ClearUnorderedAccessViewFloat(
+            buffer->uav.Get(), floatZeros);
+    }
+    isMeanResolved_ = false;
+
+    accumulatedCount_      = 0;
+    unconvergedPixelCount_ = static_cast<int>(width_ * height_);
+    remainingPixelFrames_  = double(unconvergedPixelCount_) * maxFrameCount_;
+
+    discardPendingStatistics_ = statisticsPending_;
 }
 
 void Accumulator::addNewFrame(ComPtr<ID3D11ShaderResourceView> srv)
 {
-    const float totalCount     = static_cast<float>(accumulatedCount_ + 1);
-    const float historyWeight  = accumulatedCount_ / totalCount;
-    const float newFrameWeight = 1 / totalCount;
+    readStatistics();
 
-    perFrame_.update({
-        historyWeight,
-        newFrameWeight,
-        { 0, 0 }
-    });
-
-    historySlot_->setShaderResourceView(accumulated_.srv);
     newFrameSlot_->setShaderResourceView(srv);
-    outputSlot_->setUnorderedAccessView(nextTarget_.uav);
 
     shader_.bind();
     rscMgr_.bind();
@@ -52,12 +76,48 @@ void Accumulator::addNewFrame(ComPtr<ID3D11ShaderResourceView> srv)
     shader_.unbind();
 
     ++accumulatedCount_;
-    std::swap(accumulated_, nextTarget_);
+    isMeanResolved_ = false;
+
+    // update converged mask and statistics
+
+    convergePerFrame_.update({
+        errorThreshold_,
+        static_cast<float>(minFrameCount_),
+        static_cast<float>(maxFrameCount_),
+        0
+    });
+
+    const UINT zeros[4] = { 0, 0, 0, 0 };
+    d3d11::deviceContext->ClearUnorderedAccessViewUint(
+        statisticsUAV_.Get(), zeros);
+
+    convergeShader_.bind();
+    convergeRscMgr_.bind();
+    d3d11::deviceContext.dispatch(width_, height_);
+    convergeRscMgr_.unbind();
+    convergeShader_.unbind();
+
+    if(!statisticsPending_)
+    {
+        d3d11::deviceContext->CopyResource(
+            statisticsStagingBuf_.Get(), statisticsBuf_.Get());
+        statisticsPending_ = true;
+    }
 }
 
-ComPtr<ID3D11ShaderResourceView> Accumulator::getAccumulatedOutput() const
+ComPtr<ID3D11ShaderResourceView> Accumulator::getAccumulatedOutput()
 {
-    return accumulated_.srv;
+    if(!isMeanResolved_)
+    {
+        resolveShader_.bind();
+        resolveRscMgr_.bind();
+        d3d11::deviceContext.dispatch(width_, height_);
+        resolveRscMgr_.unbind();
+        resolveShader_.unbind();
+
+        isMeanResolved_ = true;
+    }
+    return mean_.srv;
 }
 
 int Accumulator::getAccumulatedFrameCount() const noexcept
@@ -65,17 +125,48 @@ int Accumulator::getAccumulatedFrameCount() const noexcept
     return accumulatedCount_;
 }
 
+ComPtr<ID3D11ShaderResourceView> Accumulator::getConvergedMask() const
+{
+    return converged_.srv;
+}
+
+int Accumulator::getPixelCount() const noexcept
+{
+    return static_cast<int>(width_ * height_);
+}
+
+int Accumulator::getUnconvergedPixelCount() const noexcept
+{
+    return unconvergedPixelCount_;
+}
+
+double Accumulator::getRemainingPixelFrames() const noexcept
+{
+    return remainingPixelFrames_;
+}
+
+bool Accumulator::isConverged() const noexcept
+{
+    return errorThreshold_ > 0 && accumulatedCount_ >= minFrameCount_ &&
+           unconvergedPixelCount_ == 0;
+}
+
 void Accumulator::initShader()
 {
     shader_.initializeStageFromFile<d3d11::CS>("./asset/accumulate.hlsl");
     rscMgr_ = shader_.createResourceManager();
 
-    historySlot_  = rscMgr_.getShaderResourceViewSlot<d3d11::CS>("History");
     newFrameSlot_ = rscMgr_.getShaderResourceViewSlot<d3d11::CS>("NewFrame");
-    outputSlot_   = rscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Output");
+
+    convergeShader_.initializeStageFromFile<d3d11::CS>(
+        "./asset/converge.hlsl");
+    convergeRscMgr_ = convergeShader_.createResourceManager();
+
+    resolveShader_.initializeStageFromFile<d3d11::CS>("./asset/resolve.hlsl");
+    resolveRscMgr_ = resolveShader_.createResourceManager();
 }
 
-void Accumulator::initPingPongTextures()
+void Accumulator::initAccumulationTextures()
 {
     D3D11_TEXTURE2D_DESC texDesc;
     texDesc.Width          = width_;
@@ -89,34 +180,152 @@ void Accumulator::initPingPongTextures()
     texDesc.CPUAccessFlags = 0;
     texDesc.MiscFlags      = 0;
 
-    auto historyTex = d3d11::device.createTex2D(texDesc, nullptr);
-    auto outputTex  = d3d11::device.createTex2D(texDesc, nullptr);
-
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
     srvDesc.Format                    = DXGI_FORMAT_R32G32B32A32_FLOAT;
     srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels       = 1;
     srvDesc.Texture2D.MostDetailedMip = 0;
 
-    auto historySRV = d3d11::device.createSRV(historyTex, srvDesc);
-    auto outputSRV  = d3d11::device.createSRV(outputTex, srvDesc);
-
     D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
     uavDesc.Format             = DXGI_FORMAT_R32G32B32A32_FLOAT;
     uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
     uavDesc.Texture2D.MipSlice = 0;
 
-    auto historyUAV = d3d11::device.createUAV(historyTex, uavDesc);
-    auto outputUAV  = d3d11::device.createUAV(outputTex,  uavDesc);
+    auto createBuffer = [&]
+    {
+        auto tex = d3d11::device.createTex2D(texDesc, nullptr);
+        return Buffer{
+            d3d11::device.createSRV(tex, srvDesc),
+            d3d11::device.createUAV(tex, uavDesc)
+        };
+    };
+
+    sum_     = createBuffer();
+    moments_ = createBuffer();
+    mean_    = createBuffer();
+
+    // accumulate.hlsl updates the sum in place, converge.hlsl and
+    // resolve.hlsl read it
+
+    rscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Sum")
+        ->setUnorderedAccessView(sum_.uav);
+    rscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Moments")
+        ->setUnorderedAccessView(moments_.uav);
+
+    convergeRscMgr_.getShaderResourceViewSlot<d3d11::CS>("Moments")
+        ->setShaderResourceView(moments_.srv);
+
+    resolveRscMgr_.getShaderResourceViewSlot<d3d11::CS>("Sum")
+        ->setShaderResourceView(sum_.srv);
+    resolveRscMgr_.getShaderResourceViewSlot<d3d11::CS>("Moments")
+        ->setShaderResourceView(moments_.srv);
+    resolveRscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Output")
+        ->setUnorderedAccessView(mean_.uav);
+}
+
+void Accumulator::initConvergedMask()
+{
+    D3D11_TEXTURE2D_DESC texDesc;
+    texDesc.Width          = width_;
+    texDesc.Height         = height_;
+    texDesc.MipLevels      = 1;
+    texDesc.ArraySize      = 1;
+    texDesc.Format         = DXGI_FORMAT_R32_UINT;
+    texDesc.SampleDesc     = { 1, 0 };
+    texDesc.Usage          = D3D11_USAGE_DEFAULT;
+    texDesc.BindFlags      = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+    texDesc.CPUAccessFlags = 0;
+    texDesc.MiscFlags      = 0;
+
+    auto tex = d3d11::device.createTex2D(texDesc, nullptr);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    srvDesc.Format                    = DXGI_FORMAT_R32_UINT;
+    srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels       = 1;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
+    uavDesc.Format             = DXGI_FORMAT_R32_UINT;
+    uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
+    uavDesc.Texture2D.MipSlice = 0;
+
+    converged_ = {
+        d3d11::device.createSRV(tex, srvDesc),
+        d3d11::device.createUAV(tex, uavDesc)
+    };
 
-    accumulated_ = { std::move(historySRV), std::move(historyUAV) };
-    nextTarget_  = { std::move(outputSRV),  std::move(outputUAV)  };
+    rscMgr_.getShaderResourceViewSlot<d3d11::CS>("Converged")
+        ->setShaderResourceView(converged_.srv);
+    convergeRscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Converged")
+        ->setUnorderedAccessView(converged_.uav);
+}
+
+void Accumulator::initStatisticsBuffers()
+{
+    D3D11_BUFFER_DESC bufDesc;
+    bufDesc.ByteWidth           = 2 * sizeof(uint32_t);
+    bufDesc.Usage               = D3D11_USAGE_DEFAULT;
+    bufDesc.BindFlags           = D3D11_BIND_UNORDERED_ACCESS;
+    bufDesc.CPUAccessFlags      = 0;
+    bufDesc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+    bufDesc.StructureByteStride = 0;
+
+    statisticsBuf_ = d3d11::device.createBuffer(bufDesc);
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
+    uavDesc.Format              = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension       = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.FirstElement = 0;
+    uavDesc.Buffer.NumElements  = 2;
+    uavDesc.Buffer.Flags        = D3D11_BUFFER_UAV_FLAG_RAW;
+
+    statisticsUAV_ = d3d11::device.createUAV(statisticsBuf_, uavDesc);
+
+    bufDesc.Usage          = D3D11_USAGE_STAGING;
+    bufDesc.BindFlags      = 0;
+    bufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    bufDesc.MiscFlags      = 0;
+
+    statisticsStagingBuf_ = d3d11::device.createBuffer(bufDesc);
+
+    convergeRscMgr_.getUnorderedAccessViewSlot<d3d11::CS>("Statistics")
+        ->setUnorderedAccessView(statisticsUAV_);
 }
 
 void Accumulator::initPerFrameConsts()
 {
-    perFrame_.initialize();
-    rscMgr_.getConstantBufferSlot<d3d11::CS>("PerFrame")->setBuffer(perFrame_);
+    convergePerFrame_.initialize();
+    convergeRscMgr_.getConstantBufferSlot<d3d11::CS>("PerFrame")
+        ->setBuffer(convergePerFrame_);
+}
+
+void Accumulator::readStatistics()
+{
+    if(!statisticsPending_)
+        return;
+
+    // never stall the pipeline for statistics
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    const HRESULT hr = d3d11::deviceContext->Map(
+        statisticsStagingBuf_.Get(), 0, D3D11_MAP_READ,
+        D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if(FAILED(hr))
+        return;
+
+    uint32_t statistics[2];
+    std::memcpy(statistics, mapped.pData, sizeof(statistics));
+    d3d11::deviceContext->Unmap(statisticsStagingBuf_.Get(), 0);
+
+    if(!discardPendingStatistics_)
+    {
+        unconvergedPixelCount_ = static_cast<int>(statistics[0]);
+        remainingPixelFrames_  = statistics[1];
+    }
+
+    statisticsPending_        = false;
+    discardPendingStatistics_ = false;
 }
 
 PCL_END
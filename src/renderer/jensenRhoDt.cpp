@@ -4,16 +4,13 @@ PCL_BEGIN
 
 ComPtr<ID3D11ShaderResourceView> loadJensenRhoDt()
 {
-    using real = float;
-
-    static const float data[] = {
-#include "paper_rho_dt.txt"
-    };
+    const auto table = getJensenRhoDt();
+    const UINT size  = static_cast<UINT>(table->getSize());
 
     D3D11_TEXTURE3D_DESC texDesc;
-    texDesc.Width          = 64;
-    texDesc.Height         = 64;
-    texDesc.Depth          = 64;
+    texDesc.Width          = size;
+    texDesc.Height         = size;
+    texDesc.Depth          = size;
     texDesc.MipLevels      = 1;
     texDesc.Format         = DXGI_FORMAT_R32_FLOAT;
     texDesc.Usage          = D3D11_USAGE_IMMUTABLE;
@@ -22,9 +19,9 @@ ComPtr<ID3D11ShaderResourceView> loadJensenRhoDt()
     texDesc.MiscFlags      = 0;
 
     D3D11_SUBRESOURCE_DATA subrscData;
-    subrscData.pSysMem          = data;
-    subrscData.SysMemPitch      = 64 * sizeof(float);
-    subrscData.SysMemSlicePitch = 64 * 64 * sizeof(float);
+    subrscData.pSysMem          = table->getData();
+    subrscData.SysMemPitch      = size * sizeof(float);
+    subrscData.SysMemSlicePitch = size * size * sizeof(float);
 
     auto tex = d3d11::device.createTex3D(texDesc, &subrscData);
     
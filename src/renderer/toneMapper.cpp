@@ -54,7 +54,7 @@ void ToneMapper::initOutputTexture()
     texDesc.Height         = height_;
     texDesc.MipLevels      = 1;
     texDesc.ArraySize      = 1;
-    texDesc.Format         = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    texDesc.Format         = DXGI_FORMAT_R8G8B8A8_UNORM;
     texDesc.SampleDesc     = { 1, 0 };
     texDesc.Usage          = D3D11_USAGE_DEFAULT;
     texDesc.BindFlags      = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
@@ -64,7 +64,7 @@ void ToneMapper::initOutputTexture()
     auto tex = d3d11::device.createTex2D(texDesc, nullptr);
     
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-    srvDesc.Format                    = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    srvDesc.Format                    = DXGI_FORMAT_R8G8B8A8_UNORM;
     srvDesc.ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels       = 1;
     srvDesc.Texture2D.MostDetailedMip = 0;
@@ -72,7 +72,7 @@ void ToneMapper::initOutputTexture()
     auto srv = d3d11::device.createSRV(tex, srvDesc);
 
     D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
-    uavDesc.Format             = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    uavDesc.Format             = DXGI_FORMAT_R8G8B8A8_UNORM;
     uavDesc.ViewDimension      = D3D11_UAV_DIMENSION_TEXTURE2D;
     uavDesc.Texture2D.MipSlice = 0;
 
@@ -1,3 +1,4 @@
+#include <pcl/core/jensenMaterial.h>
 #include <pcl/renderer/jensenRhoDt.h>
 #include <pcl/renderer/tracer.h>
 
@@ -10,7 +11,10 @@ Tracer::Tracer(
     int         spp)
     : outputSize_(outputSize), paperSize_(paperSize),
       paperDistance_(paperDistance), backLightDistance_(paperDistance),
-      spp_(spp), envLight_(0.15f, 0.15f, 0.15f), eyeZ_(-1)
+      spp_(spp), previewScale_(1),
+      maxScatterDepth_(DEFAULT_MAX_SCATTER_DEPTH),
+      envLight_(0.15f, 0.15f, 0.15f), eyeZ_(-1),
+      dirtyMaterialBegin_(0), dirtyMaterialEnd_(0)
 {
     initShader();
     initRenderTarget();
@@ -61,66 +65,7 @@ void Tracer::setPaperDiffuse(int z, float reflectionRatio)
     PaperMaterial paperMaterial{};
     paperMaterial.type = PaperMaterial::TYPE_DIFFUSE;
     paperMaterial.m01  = reflectionRatio;
-
-    D3D11_BOX box;
-    box.left   = static_cast<UINT>(sizeof(PaperMaterial) * z);
-    box.right  = static_cast<UINT>(sizeof(PaperMaterial) * (z + 1));
-    box.top    = 0;
-    box.bottom = 1;
-    box.front  = 0;
-    box.back   = 1;
-
-    d3d11::deviceContext->UpdateSubresource(
-        paperMaterialsBuf_.Get(), 0, &box, &paperMaterial, 0, 0);
-}
-
-namespace
-{
-    std::pair<Float3, Float3> computeRdAndTd(
-        int n, const Float3 &color,
-        float sigma_s, float sigma_a, float d,
-        float gf, float gb, float wf, float wb) noexcept
-    {
-        const float sigma_s_bar = (1 - (wb * gb + wf * gf)) * sigma_s;
-        const float sigma_t_bar = sigma_a + sigma_s_bar;
-        const float alpha_bar = sigma_s_bar / sigma_t_bar;
-        const float sigma_tr = std::sqrt(3 * sigma_a * sigma_t_bar);
-
-        auto sign = [](float x) { return x > 0 ? 1.0f : -1.0f; };
-
-        const float l = 1 / sigma_t_bar;
-
-        const Float3 A = (Float3(1) + color) / (Float3(float(1.001)) - color);
-
-        const float D = 1 / (3 * sigma_t_bar);
-
-        const Float3 zb = 2 * A * D;
-
-        auto z_r_i = [&](int i) { return float(2) * i * (d + zb + zb) + l; };
-        auto z_v_i = [&](int i) { return float(2) * i * (d + zb + zb) - l - 2 * zb; };
-
-        Float3 Rd, Td;
-        for(int i = -n; i <= n; ++i)
-        {
-            const Float3 zri = z_r_i(i);
-            const Float3 zvi = z_v_i(i);
-
-            for(int c = 0; c < 3; ++c)
-            {
-                Rd[c] +=
-                    sign(zri[c]) * std::exp(-sigma_tr * std::abs(zri[c]))
-                  - sign(zvi[c]) * std::exp(-sigma_tr * std::abs(zvi[c]));
-
-                Td[c] +=
-                    sign(d - zri[c]) * std::exp(-sigma_tr * std::abs(d - zri[c]))
-                  - sign(d - zvi[c]) * std::exp(-sigma_tr * std::abs(d - zvi[c]));
-            }
-        }
-        Rd *= alpha_bar / 2;
-        Td *= alpha_bar / 2;
-
-        return { Rd, Td };
-    }
+    setPaperMaterial(z, paperMaterial);
 }
 
 void Tracer::setPaperJensen(
@@ -131,44 +76,29 @@ void Tracer::setPaperJensen(
     float d, float sigmaS, float sigmaA,
     const Float3 &diffusionAlbedo)
 {
-    d = (std::max)(0.05f, d);
-
-    const float sigmaT = sigmaS + sigmaA;
-    const float alpha  = sigmaS / sigmaT;
-    const float tauD   = d * sigmaT;
-
-    const auto [Rd, Td] = computeRdAndTd(
-        4, diffusionAlbedo, sigmaS, sigmaA, d, gf, gb, wf, wb);
+    const JensenMaterial jensen = computeJensenMaterial(
+        gf, gb, wf, wb, frontEta, backEta, frontM, backM,
+        d, sigmaS, sigmaA, diffusionAlbedo);
 
     PaperMaterial material{};
     material.type = PaperMaterial::TYPE_JENSEN;
-    material.m01 = frontEta;
-    material.m02 = backEta;
-    material.m03 = (std::max)(0.01f, frontM);
-    material.m04 = (std::max)(0.01f, backM);
-    material.m05 = Rd.x;
-    material.m06 = Rd.y;
-    material.m07 = Rd.z;
-    material.m08 = Td.x;
-    material.m09 = Td.y;
-    material.m10 = Td.z;
-    material.m11 = alpha;
-    material.m12 = tauD;
-    material.m13 = wf;
-    material.m14 = gf;
-    material.m15 = wb;
-    material.m16 = gb;
-
-    D3D11_BOX box;
-    box.left = static_cast<UINT>(sizeof(PaperMaterial) * z);
-    box.right = static_cast<UINT>(sizeof(PaperMaterial) * (z + 1));
-    box.top = 0;
-    box.bottom = 1;
-    box.front = 0;
-    box.back = 1;
-
-    d3d11::deviceContext->UpdateSubresource(
-        paperMaterialsBuf_.Get(), 0, &box, &material, 0, 0);
+    material.m01 = jensen.etaFront;
+    material.m02 = jensen.etaBack;
+    material.m03 = jensen.mFront;
+    material.m04 = jensen.mBack;
+    material.m05 = jensen.Rd.x;
+    material.m06 = jensen.Rd.y;
+    material.m07 = jensen.Rd.z;
+    material.m08 = jensen.Td.x;
+    material.m09 = jensen.Td.y;
+    material.m10 = jensen.Td.z;
+    material.m11 = jensen.alpha;
+    material.m12 = jensen.tauD;
+    material.m13 = jensen.HGArg.x;
+    material.m14 = jensen.HGArg.y;
+    material.m15 = jensen.HGArg.z;
+    material.m16 = jensen.HGArg.w;
+    setPaperMaterial(z, material);
 }
 
 void Tracer::setBackLightRadiance(const agz::math::color3f *data)
@@ -207,8 +137,10 @@ void Tracer::setEyeZ(float z) noexcept
     eyeZ_ = z;
 }
 
-void Tracer::render() const
+void Tracer::render()
 {
+    flushPaperMaterials();
+
     perFrame_.update({
         static_cast<uint32_t>(outputSize_.x),
         static_cast<uint32_t>(outputSize_.y),
@@ -219,29 +151,50 @@ void Tracer::render() const
         paperDistance_,
         backLightDistance_,
         envLight_,
-        eyeZ_
+        eyeZ_,
+        static_cast<uint32_t>(previewScale_),
+        static_cast<uint32_t>(maxScatterDepth_),
+        { 0, 0 }
     });
 
     tracingShader_.bind();
     tracingResources_.bind();
 
     d3d11::deviceContext.dispatch(
-        static_cast<UINT>(outputSize_.x),
-        static_cast<UINT>(outputSize_.y));
+        static_cast<UINT>((outputSize_.x + previewScale_ - 1) / previewScale_),
+        static_cast<UINT>((outputSize_.y + previewScale_ - 1) / previewScale_));
 
     tracingResources_.unbind();
     tracingShader_.unbind();
 }
 
+void Tracer::setPreviewScale(int scale) noexcept
+{
+    previewScale_ = (std::max)(scale, 1);
+}
+
+void Tracer::setMaxScatterDepth(int maxScatterDepth) noexcept
+{
+    maxScatterDepth_ = (std::max)(maxScatterDepth, 1);
+}
+
 ComPtr<ID3D11ShaderResourceView> Tracer::getOutput() const
 {
     return outputSRV_;
 }
 
+void Tracer::setConvergedMask(ComPtr<ID3D11ShaderResourceView> mask)
+{
+    convergedMask_ = std::move(mask);
+    tracingResources_.getShaderResourceViewSlot<d3d11::CS>("Converged")
+        ->setShaderResourceView(convergedMask_);
+}
+
 void Tracer::initShader()
 {
-    const D3D_SHADER_MACRO macros[2] = {
-        { "MAX_DEPTH", "20" },
+    const D3D_SHADER_MACRO macros[3] = {
+        { "MAX_DEPTH",    "20" },
+        { "RR_MIN_DEPTH", "3"  },
         { nullptr, nullptr }
     };
 
@@ -323,6 +276,43 @@ void Tracer::initPaperTexture()
     papersSRV_.Swap(srv);
 }
 
+void Tracer::setPaperMaterial(int z, const PaperMaterial &material)
+{
+    paperMaterials_[z] = material;
+
+    if(dirtyMaterialBegin_ < dirtyMaterialEnd_)
+    {
+        dirtyMaterialBegin_ = (std::min)(dirtyMaterialBegin_, z);
+        dirtyMaterialEnd_   = (std::max)(dirtyMaterialEnd_, z + 1);
+    }
+    else
+    {
+        dirtyMaterialBegin_ = z;
+        dirtyMaterialEnd_   = z + 1;
+    }
+}
+
+void Tracer::flushPaperMaterials()
+{
+    if(dirtyMaterialBegin_ >= dirtyMaterialEnd_)
+        return;
+
+    D3D11_BOX box;
+    box.left   = static_cast<UINT>(sizeof(PaperMaterial) * dirtyMaterialBegin_);
+    box.right  = static_cast<UINT>(sizeof(PaperMaterial) * dirtyMaterialEnd_);
+    box.top    = 0;
+    box.bottom = 1;
+    box.front  = 0;
+    box.back   = 1;
+
+    d3d11::deviceContext->UpdateSubresource(
+        paperMaterialsBuf_.Get(), 0, &box,
+        &paperMaterials_[dirtyMaterialBegin_], 0, 0);
+
+    dirtyMaterialBegin_ = 0;
+    dirtyMaterialEnd_   = 0;
+}
+
 void Tracer::initPaperMaterials()
 {
     const UINT byteSize = static_cast<UINT>(
@@ -348,6 +338,10 @@ void Tracer::initPaperMaterials()
 
     paperMaterialsBuf_.Swap(buf);
     paperMaterialsSRV_.Swap(srv);
+
+    paperMaterials_.assign(paperSize_.z, PaperMaterial{});
+    dirtyMaterialBegin_ = 0;
+    dirtyMaterialEnd_   = paperSize_.z;
 }
 
 void Tracer::initBackLightTexture()
@@ -454,6 +448,8 @@ void Tracer::setResourceBindings()
         ->setShaderResourceView(jensenRhoDt_);
     tracingResources_.getUnorderedAccessViewSlot<d3d11::CS>("Output")
         ->setUnorderedAccessView(outputUAV_);
+    tracingResources_.getShaderResourceViewSlot<d3d11::CS>("Converged")
+        ->setShaderResourceView(convergedMask_);
     tracingResources_.getSamplerSlot<d3d11::CS>("JensenLinearSampler")
         ->setSampler(jensenLinearSampler_);
 }
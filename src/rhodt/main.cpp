@@ -0,0 +1,110 @@
+#include <chrono>
+#include <iostream>
+
+#include <pcl/core/jensenRhoDt.h>
+#include <pcl/core/threadPool.h>
+
+namespace
+{
+
+    const char *USAGE = R"___(usage: pcl-rho-dt [options]
+
+    --size n                table resolution, default: 64
+    --samples n             ggx samples per texel, default: 1024
+    --threads n             default: all cores
+    --output filename       default: ./asset/cache/rho_dt_<size>.bin
+
+    the default output is the cache read by the renderers at startup. they
+    ignore and overwrite caches computed with fewer than 1024 samples.
+)___";
+
+    struct RhoDtParams
+    {
+        int size        = pcl::JENSEN_RHO_DT_DEFAULT_SIZE;
+        int sampleCount = pcl::JENSEN_RHO_DT_DEFAULT_SAMPLE_COUNT;
+        int threadCount = 0;
+
+        std::string outputFilename;
+    };
+
+    int parseInt(const std::string &opt, const std::string &value)
+    {
+        try
+        {
+            return std::stoi(value);
+        }
+        catch(...)
+        {
+            throw pcl::PCLException(
+                "invalid value of " + opt + ": " + value);
+        }
+    }
+
+    RhoDtParams parseArgs(int argc, char *argv[])
+    {
+        RhoDtParams params;
+
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string opt = argv[i];
+            if(i + 1 >= argc)
+                throw pcl::PCLException("missing value of " + opt);
+            const std::string value = argv[++i];
+
+            if(opt == "--size")
+                params.size = (std::max)(parseInt(opt, value), 2);
+            else if(opt == "--samples")
+                params.sampleCount = (std::max)(parseInt(opt, value), 1);
+            else if(opt == "--threads")
+                params.threadCount = parseInt(opt, value);
+            else if(opt == "--output")
+                params.outputFilename = value;
+            else
+                throw pcl::PCLException("unknown option: " + opt);
+        }
+
+        if(params.outputFilename.empty())
+        {
+            params.outputFilename =
+                pcl::getJensenRhoDtCacheFilename(params.size);
+        }
+
+        return params;
+    }
+
+    void run(const RhoDtParams &params)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const auto start = Clock::now();
+
+        pcl::ThreadPool threadPool(params.threadCount);
+        const auto data = pcl::computeJensenRhoDt(
+            params.size, params.sampleCount, threadPool);
+
+        pcl::saveJensenRhoDt(
+            params.outputFilename, params.size, params.sampleCount,
+            data.data());
+
+        const double seconds = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        std::cout << "computed " << params.size << "^3 texels with "
+                  << params.sampleCount << " samples in " << seconds
+                  << "s, saved to " << params.outputFilename << std::endl;
+    }
+
+} // namespace anonymous
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        run(parseArgs(argc, argv));
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << USAGE;
+        return -1;
+    }
+}